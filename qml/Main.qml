@@ -13,6 +13,9 @@ ApplicationWindow {
     minimumHeight: 650
     title: "OCR + LLM Document Processor"
 
+    // Pages of the current job left as placeholders.
+    property int failedPages: 0
+
     OcrProcessor { id: processor }
 
     ScrollView {
@@ -107,12 +110,12 @@ ApplicationWindow {
                         Label { text: "OCR Engine:"; Layout.preferredWidth: 120 }
                         ComboBox {
                             id: engineBox
-                            model: ["Tesseract", "Google Vision"]
+                            model: ["Tesseract", "Google Vision", "Tesseract + Vision"]
                             Layout.preferredWidth: 200
                             onCurrentTextChanged: {
                                 processor.setOcrEngine(currentText);
-                                tessPathRow.visible = (currentText === "Tesseract");
-                                googleKeyRow.visible = (currentText === "Google Vision");
+                                tessPathRow.visible = (currentText !== "Google Vision");
+                                googleKeyRow.visible = (currentText !== "Tesseract");
                             }
                         }
                     }
@@ -121,7 +124,7 @@ ApplicationWindow {
                     RowLayout {
                         id: tessPathRow
                         Layout.fillWidth: true
-                        visible: engineBox.currentText === "Tesseract"
+                        visible: engineBox.currentText !== "Google Vision"
                         Label { text: "Tesseract Path:"; Layout.preferredWidth: 120 }
                         TextField {
                             id: tessPath
@@ -135,11 +138,25 @@ ApplicationWindow {
                         }
                     }
 
+                    // Tesseract speed/accuracy profile
+                    RowLayout {
+                        Layout.fillWidth: true
+                        visible: engineBox.currentText !== "Google Vision"
+                        Label { text: "OCR Profile:"; Layout.preferredWidth: 120 }
+                        ComboBox {
+                            id: profileBox
+                            model: processor.ocrProfiles()
+                            currentIndex: 1
+                            Layout.preferredWidth: 200
+                            onCurrentTextChanged: processor.setOcrProfile(currentText)
+                        }
+                    }
+
                     // Google Vision Service Account JSON
                     RowLayout {
                         id: googleKeyRow
                         Layout.fillWidth: true
-                        visible: engineBox.currentText === "Google Vision"
+                        visible: engineBox.currentText !== "Tesseract"
                         Label { text: "Google Vision Key (JSON):"; Layout.preferredWidth: 120 }
                         TextField {
                             id: googleKey
@@ -178,6 +195,39 @@ ApplicationWindow {
                 }
             }
 
+            // Re-run Checkbox
+            CheckBox {
+                id: rerunCheck
+                text: "Re-run only the pages that failed in the output file"
+                onCheckedChanged: processor.setRerunFailedPages(checked)
+            }
+
+            // Extra output formats, written next to the output file
+            RowLayout {
+                Layout.fillWidth: true
+                Label { text: "Also write:"; Layout.preferredWidth: 120 }
+                Repeater {
+                    id: formatRepeater
+                    model: [
+                        { key: "hocr", label: "hOCR" },
+                        { key: "tsv", label: "TSV" },
+                        { key: "alto", label: "ALTO XML" },
+                        { key: "pdf", label: "Searchable PDF" }
+                    ]
+                    CheckBox {
+                        text: modelData.label
+                        onCheckedChanged: {
+                            var formats = [];
+                            for (var i = 0; i < formatRepeater.count; ++i) {
+                                var box = formatRepeater.itemAt(i);
+                                if (box && box.checked) formats.push(formatRepeater.model[i].key);
+                            }
+                            processor.setOutputFormats(formats);
+                        }
+                    }
+                }
+            }
+
             // LLM Processing GroupBox
             GroupBox {
                 id: llmFrame
@@ -196,7 +246,7 @@ ApplicationWindow {
                         ComboBox {
                             id: llmDropdown
                             Layout.fillWidth: true
-                            model: ["OpenAI: gpt-4o", "OpenRouter: deepseek/deepseek-chat"]
+                            model: processor.llmProviders()
                             onCurrentTextChanged: {
                                 processor.setLlmProvider(currentText);
                                 if (currentText.includes("OpenAI")) {
@@ -210,6 +260,13 @@ ApplicationWindow {
                         }
                     }
 
+                    // Bulk mode
+                    CheckBox {
+                        id: bulkCheck
+                        text: "Bulk mode (provider batch API: cheaper, results within 24 hours)"
+                        onCheckedChanged: processor.setLlmBulkMode(checked)
+                    }
+
                     // API Key
                     RowLayout {
                         Layout.fillWidth: true
@@ -272,6 +329,7 @@ ApplicationWindow {
                         onClicked: {
                             startButton.enabled = false;
                             stopButton.enabled = true;
+                            failedPages = 0;
                             processor.startProcessing();
                         }
                     }
@@ -302,6 +360,54 @@ ApplicationWindow {
                 }
             }
 
+            // Per-page results, filled in as pages finish
+            GroupBox {
+                title: "Pages (" + processor.pages.finishedCount + "/" + processor.pages.count + ")"
+                Layout.fillWidth: true
+                visible: processor.pages.count > 0
+                padding: 15
+
+                RowLayout {
+                    width: parent.width
+                    spacing: 10
+
+                    ListView {
+                        id: pageList
+                        Layout.preferredWidth: 300
+                        Layout.preferredHeight: 220
+                        clip: true
+                        model: processor.pages
+                        currentIndex: -1
+                        ScrollBar.vertical: ScrollBar {}
+
+                        delegate: ItemDelegate {
+                            width: ListView.view.width
+                            highlighted: ListView.isCurrentItem
+                            text: "Page " + pageNumber + " \u2013 " + stateName
+                                  + (confidence >= 0 ? "  (conf " + confidence + ")" : "")
+                                  + (ocrMs >= 0 ? "  " + renderMs + " + " + ocrMs + " ms" : "")
+                            ToolTip.visible: hovered && error !== ""
+                            ToolTip.text: error
+                            onClicked: pageList.currentIndex = index
+                        }
+                    }
+
+                    ScrollView {
+                        Layout.fillWidth: true
+                        Layout.preferredHeight: 220
+
+                        TextArea {
+                            readOnly: true
+                            wrapMode: TextArea.Wrap
+                            placeholderText: "Select a finished page to see its text"
+                            // Re-read when the selected page's row changes.
+                            text: pageList.currentIndex >= 0 && processor.pages.finishedCount >= 0
+                                  ? processor.pages.text(pageList.currentIndex) : ""
+                        }
+                    }
+                }
+            }
+
             Item { Layout.fillHeight: true }
         }
     }
@@ -365,8 +471,14 @@ ApplicationWindow {
             prog.value = percent;
         }
 
+        function onPageFailed(page, error) {
+            failedPages += 1;
+        }
+
         function onFinished(outPath) {
             statusLabel.text = "Processing complete! Output saved to: " + outPath;
+            if (failedPages > 0)
+                statusLabel.text += " (" + failedPages + " page(s) failed and were left as placeholders)";
             prog.value = 100;
             startButton.enabled = true;
             stopButton.enabled = false;
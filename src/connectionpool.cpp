@@ -0,0 +1,35 @@
+#include "connectionpool.h"
+#include <QNetworkAccessManager>
+#include <QThreadStorage>
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif
+
+namespace ocr {
+
+QNetworkAccessManager *threadNetworkManager() {
+    static QThreadStorage<QNetworkAccessManager *> managers;
+    if (!managers.hasLocalData()) {
+        managers.setLocalData(new QNetworkAccessManager());
+    }
+    return managers.localData();
+}
+
+void preconnect(const QList<QUrl> &urls) {
+    QNetworkAccessManager *netman = threadNetworkManager();
+    for (const QUrl &url : urls) {
+        if (!url.isValid() || url.host().isEmpty()) continue;
+        if (url.scheme() == "https") {
+#ifndef QT_NO_SSL
+            QSslConfiguration conf = QSslConfiguration::defaultConfiguration();
+            conf.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                          QSslConfiguration::NextProtocolHttp1_1});
+            netman->connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(443)), conf);
+#endif
+        } else {
+            netman->connectToHost(url.host(), static_cast<quint16>(url.port(80)));
+        }
+    }
+}
+
+} // namespace ocr
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QList>
+#include <QUrl>
+
+class QNetworkAccessManager;
+
+namespace ocr {
+
+// Long-lived QNetworkAccessManager for the calling thread, created on first use and
+// destroyed when the thread exits. Everything a thread sends goes through it, so
+// keep-alive connections and HTTP/2 sessions are shared by all pages and jobs the
+// thread handles instead of paying DNS/TCP/TLS set-up per request.
+QNetworkAccessManager *threadNetworkManager();
+
+// Opens connections to the hosts of urls on the calling thread's manager ahead of the
+// first request (TLS with HTTP/2 offered via ALPN for https). Non-blocking.
+void preconnect(const QList<QUrl> &urls);
+
+} // namespace ocr
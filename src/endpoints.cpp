@@ -0,0 +1,47 @@
+#include "endpoints.h"
+#include <QPair>
+
+namespace ocr {
+
+static QString trimSlash(const QString &url) {
+    QString u = url.trimmed();
+    while (u.endsWith('/')) u.chop(1);
+    return u;
+}
+
+QUrl Endpoints::visionAnnotateUrl() const {
+    return QUrl(trimSlash(visionBaseUrl) + "/v1/images:annotate");
+}
+
+QUrl Endpoints::chatCompletionsUrl(const QString &provider) const {
+    if (provider == "OpenAI") return QUrl(trimSlash(openAiBaseUrl) + "/chat/completions");
+    if (provider == "OpenRouter") return QUrl(trimSlash(openRouterBaseUrl) + "/chat/completions");
+    return QUrl();
+}
+
+bool Endpoints::setBaseUrl(const QString &service, const QString &url) {
+    const QString key = service.toLower();
+    if (key == "vision") visionBaseUrl = url;
+    else if (key == "oauth") oauthTokenUrl = url;
+    else if (key == "openai") openAiBaseUrl = url;
+    else if (key == "openrouter") openRouterBaseUrl = url;
+    else return false;
+    return true;
+}
+
+Endpoints Endpoints::fromEnvironment() {
+    Endpoints e;
+    const QPair<const char *, const char *> vars[] = {
+        {"OCR_VISION_BASE_URL", "vision"},
+        {"OCR_OAUTH_TOKEN_URL", "oauth"},
+        {"OCR_OPENAI_BASE_URL", "openai"},
+        {"OCR_OPENROUTER_BASE_URL", "openrouter"},
+    };
+    for (const auto &v : vars) {
+        QString value = qEnvironmentVariable(v.first);
+        if (!value.isEmpty()) e.setBaseUrl(v.second, value);
+    }
+    return e;
+}
+
+} // namespace ocr
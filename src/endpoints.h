@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QString>
+#include <QUrl>
+
+namespace ocr {
+
+// Base URLs of every remote service the app talks to. Defaults point at the real
+// providers; each can be overridden (e.g. to the bundled mock server) through the
+// environment or OcrProcessor::setEndpointBaseUrl().
+struct Endpoints {
+    QString visionBaseUrl = "https://vision.googleapis.com";
+    QString oauthTokenUrl = "https://oauth2.googleapis.com/token";
+    QString openAiBaseUrl = "https://api.openai.com/v1";
+    QString openRouterBaseUrl = "https://openrouter.ai/api/v1";
+
+    QUrl visionAnnotateUrl() const;
+    // Chat completions URL for "OpenAI" / "OpenRouter"; invalid QUrl for anything else.
+    QUrl chatCompletionsUrl(const QString &provider) const;
+
+    // Applies a base URL override for "vision", "oauth", "openai" or "openrouter".
+    // Returns false for an unknown service name.
+    bool setBaseUrl(const QString &service, const QString &url);
+
+    // Defaults, overridden by OCR_VISION_BASE_URL, OCR_OAUTH_TOKEN_URL,
+    // OCR_OPENAI_BASE_URL and OCR_OPENROUTER_BASE_URL when set.
+    static Endpoints fromEnvironment();
+};
+
+} // namespace ocr
@@ -0,0 +1,279 @@
+#include "httpclient.h"
+#include "tracing.h"
+#include "ratelimiter.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIODevice>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QEventLoop>
+#include <QMutexLocker>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <stdexcept>
+
+namespace ocr {
+
+RetryBudget::RetryBudget(const RetryPolicy &policy)
+    : tokens_(policy.retryBudgetMin), ratio_(policy.retryBudgetRatio),
+      cap_(std::max(policy.retryBudgetMin, 1)) {}
+
+void RetryBudget::onRequest() {
+    QMutexLocker lock(&mutex_);
+    tokens_ = std::min(cap_, tokens_ + ratio_);
+}
+
+bool RetryBudget::tryConsume() {
+    QMutexLocker lock(&mutex_);
+    if (tokens_ < 1.0) return false;
+    tokens_ -= 1.0;
+    return true;
+}
+
+int parseRetryAfterMs(const QByteArray &value) {
+    const QByteArray v = value.trimmed();
+    if (v.isEmpty()) return -1;
+    bool ok = false;
+    const int seconds = v.toInt(&ok);
+    if (ok) return seconds >= 0 ? seconds * 1000 : -1;
+    const QDateTime when = QDateTime::fromString(QString::fromLatin1(v), Qt::RFC2822Date);
+    if (!when.isValid()) return -1;
+    return static_cast<int>(std::max<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(when)));
+}
+
+bool isRetryableStatus(int httpStatus) {
+    return httpStatus == 408 || httpStatus == 429 || httpStatus == 500 || httpStatus == 502 ||
+           httpStatus == 503 || httpStatus == 504;
+}
+
+static bool isRetryableNetworkError(QNetworkReply::NetworkError error) {
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int backoffDelayMs(int retry, const RetryPolicy &policy) {
+    const qint64 ceiling = std::min<qint64>(policy.maxDelayMs,
+                                            qint64(policy.baseDelayMs) << std::min(retry - 1, 20));
+    return QRandomGenerator::global()->bounded(static_cast<int>(ceiling) + 1);
+}
+
+int rateLimitPauseMs(const QNetworkReply *reply) {
+    int pause = parseRetryAfterMs(reply->rawHeader("Retry-After"));
+    const char *const kinds[] = {"requests", "tokens"};
+    for (const char *kind : kinds) {
+        const QByteArray remaining = reply->rawHeader(QByteArray("x-ratelimit-remaining-") + kind);
+        if (!remaining.isEmpty() && remaining.trimmed().toLongLong() <= 0) {
+            pause = std::max(pause, parseResetDurationMs(reply->rawHeader(QByteArray("x-ratelimit-reset-") + kind)));
+        }
+    }
+    return pause;
+}
+
+HttpClient::HttpClient(QNetworkAccessManager *netman, const RetryPolicy &policy,
+                       std::shared_ptr<RetryBudget> budget, const std::atomic<bool> *stopFlag)
+    : netman_(netman), policy_(policy), budget_(std::move(budget)), stopFlag_(stopFlag) {
+    if (!budget_) budget_ = std::make_shared<RetryBudget>(policy_);
+}
+
+void HttpClient::setRateLimiter(std::shared_ptr<AdaptiveLimiter> limiter) {
+    limiter_ = std::move(limiter);
+}
+
+QByteArray HttpClient::post(const QNetworkRequest &request, const QByteArray &body,
+                            const QString &label, double costTokens) {
+    return postWith(
+        request, [this, body](const QNetworkRequest &req) { return netman_->post(req, body); },
+        label, costTokens);
+}
+
+QByteArray HttpClient::post(const QNetworkRequest &request, const BodyFactory &makeBody,
+                            const QString &label, double costTokens) {
+    return postWith(
+        request,
+        [this, makeBody](const QNetworkRequest &req) {
+            QIODevice *body = makeBody();
+            QNetworkRequest withLength(req);
+            withLength.setHeader(QNetworkRequest::ContentLengthHeader, body->size());
+            QNetworkReply *reply = netman_->post(withLength, body);
+            body->setParent(reply);
+            return reply;
+        },
+        label, costTokens);
+}
+
+QByteArray HttpClient::get(const QNetworkRequest &request, const QString &label) {
+    return postWith(
+        request, [this](const QNetworkRequest &req) { return netman_->get(req); }, label, 0);
+}
+
+QByteArray HttpClient::postWith(const QNetworkRequest &request, const Sender &sender,
+                                const QString &label, double costTokens) {
+    // Let HTTP/2-capable endpoints multiplex concurrent requests over one connection.
+    QNetworkRequest req(request);
+    req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    budget_->onRequest();
+    for (int attemptNo = 1;; ++attemptNo) {
+        if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
+
+        HttpResult result = attempt(req, sender, label, costTokens);
+        if (result.ok) return result.body;
+        if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
+
+        if (!result.retryable || attemptNo >= policy_.maxAttempts || !budget_->tryConsume()) {
+            throw std::runtime_error(
+                QString("%1 request failed: %2").arg(label, result.error).toStdString());
+        }
+        // The server knows best when it will have capacity again.
+        const int delay = result.retryAfterMs >= 0 ? std::min(result.retryAfterMs, 300000)
+                                                   : backoffDelayMs(attemptNo, policy_);
+        sleepFor(delay);
+    }
+}
+
+HttpResult HttpClient::attempt(const QNetworkRequest &request, const Sender &sender,
+                               const QString &label, double costTokens) {
+    // Waiting for a limiter slot is not part of the request's deadline.
+    if (limiter_) limiter_->acquire(costTokens, stopFlag_);
+
+    TraceSpan span("http_request", "network", label);
+
+    QEventLoop loop;
+    QElapsedTimer clock;
+    clock.start();
+    QList<QNetworkReply *> replies;
+    QHash<QNetworkReply *, qint64> sentAt;
+    QNetworkReply *winner = nullptr;
+    QNetworkReply *lastFailed = nullptr;
+    int pending = 0;
+    bool timedOut = false;
+    bool cancelled = false;
+
+    // The caller has already taken a limiter slot for this send.
+    auto send = [&]() {
+        QNetworkReply *reply = sender(request);
+        replies.append(reply);
+        sentAt.insert(reply, clock.elapsed());
+        ++pending;
+        QObject::connect(reply, &QNetworkReply::finished, &loop, [&, reply]() {
+            --pending;
+            const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            if (limiter_) {
+                AdaptiveLimiter::Outcome outcome = AdaptiveLimiter::Outcome::Success;
+                if (status == 429 || status == 503) outcome = AdaptiveLimiter::Outcome::Throttled;
+                else if (reply->error() != QNetworkReply::NoError) outcome = AdaptiveLimiter::Outcome::Failed;
+                limiter_->release(outcome, clock.elapsed() - sentAt.take(reply), rateLimitPauseMs(reply));
+            }
+            if (!winner && reply->error() == QNetworkReply::NoError && status < 400) {
+                winner = reply;
+                loop.quit();
+            } else {
+                lastFailed = reply;
+                if (pending == 0) loop.quit();
+            }
+        });
+    };
+    send();
+
+    QTimer deadline;
+    deadline.setSingleShot(true);
+    if (policy_.timeoutMs > 0) {
+        QObject::connect(&deadline, &QTimer::timeout, &loop, [&]() {
+            timedOut = true;
+            loop.quit();
+        });
+        deadline.start(policy_.timeoutMs);
+    }
+
+    // A hedge is a duplicate of a request that is slower than usual; whichever copy
+    // answers first wins and the other is aborted.
+    QTimer hedge;
+    hedge.setSingleShot(true);
+    if (policy_.hedgeAfterMs > 0) {
+        QObject::connect(&hedge, &QTimer::timeout, &loop, [&]() {
+            if (pending == 0 || (limiter_ && !limiter_->tryAcquire(costTokens))) return;
+            if (budget_->tryConsume()) {
+                send();
+            } else if (limiter_) {
+                limiter_->release(AdaptiveLimiter::Outcome::Cancelled, 0);
+            }
+        });
+        hedge.start(policy_.hedgeAfterMs);
+    }
+
+    // A stop aborts whatever is still in flight instead of waiting for the reply.
+    QTimer stopPoll;
+    if (stopFlag_) {
+        QObject::connect(&stopPoll, &QTimer::timeout, &loop, [&]() {
+            if (!stopFlag_->load()) return;
+            cancelled = true;
+            loop.quit();
+        });
+        stopPoll.start(50);
+    }
+
+    loop.exec();
+
+    HttpResult result;
+    QNetworkReply *answered = winner ? winner : lastFailed;
+    if (answered) {
+        result.ok = (answered == winner);
+        result.status = answered->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        result.body = answered->readAll();
+        if (!result.ok) {
+            result.error = result.status > 0
+                               ? QString("HTTP %1: %2").arg(result.status).arg(answered->errorString())
+                               : answered->errorString();
+            result.retryAfterMs = parseRetryAfterMs(answered->rawHeader("Retry-After"));
+            result.retryable = result.status > 0 ? isRetryableStatus(result.status)
+                                                 : isRetryableNetworkError(answered->error());
+        }
+    } else if (timedOut) {
+        result.error = QString("timed out after %1 ms").arg(policy_.timeoutMs);
+        result.retryable = true;
+    } else if (cancelled) {
+        result.error = "cancelled";
+    }
+
+    for (QNetworkReply *reply : replies) {
+        QObject::disconnect(reply, nullptr, &loop, nullptr);
+        if (reply->isRunning()) {
+            reply->abort();
+            // A deadline miss counts against the window; a losing hedge does not.
+            if (limiter_ && sentAt.contains(reply)) {
+                limiter_->release(timedOut && !winner ? AdaptiveLimiter::Outcome::Failed
+                                                      : AdaptiveLimiter::Outcome::Cancelled,
+                                  clock.elapsed() - sentAt.value(reply));
+            }
+        }
+        // Not deleteLater(): page and LLM threads have no event loop to run it, and the
+        // reply owns the request body, which would otherwise pin the page's buffer.
+        delete reply;
+    }
+    return result;
+}
+
+void HttpClient::sleepFor(int ms) {
+    QDeadlineTimer until(ms);
+    while (!until.hasExpired()) {
+        if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
+        QThread::msleep(static_cast<unsigned long>(std::min<qint64>(50, until.remainingTime())));
+    }
+}
+
+} // namespace ocr
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QNetworkRequest>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class QIODevice;
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace ocr {
+
+class AdaptiveLimiter;
+
+struct RetryPolicy {
+    int maxAttempts = 4;            // first try included
+    int baseDelayMs = 500;          // backoff before the first retry, doubled each time
+    int maxDelayMs = 30000;
+    int timeoutMs = 120000;         // per attempt; 0 = no deadline
+    int hedgeAfterMs = 0;           // send a duplicate if no answer by then; 0 = off
+    double retryBudgetRatio = 0.2;  // retries (and hedges) earned per request sent
+    int retryBudgetMin = 10;        // retries always available at the start of a job
+};
+
+// Bounds the extra load retries and hedges add: every request deposits
+// retryBudgetRatio tokens, every retry or hedge withdraws one. Shared by all requests
+// of a job so a failing provider cannot multiply the job's cost.
+class RetryBudget {
+public:
+    explicit RetryBudget(const RetryPolicy &policy);
+
+    void onRequest();
+    bool tryConsume();
+
+private:
+    QMutex mutex_;
+    double tokens_;
+    double ratio_;
+    double cap_;
+};
+
+struct HttpResult {
+    bool ok = false;
+    bool retryable = false;
+    int status = 0;
+    int retryAfterMs = -1;
+    QByteArray body;
+    QString error;
+};
+
+// Synchronous POST (and GET) with per-attempt deadlines, exponential backoff with full jitter,
+// Retry-After support and optional hedging. Must be used on the thread that owns netman.
+// Raising stopFlag aborts the request in flight within about 50 ms.
+class HttpClient {
+public:
+    HttpClient(QNetworkAccessManager *netman, const RetryPolicy &policy,
+               std::shared_ptr<RetryBudget> budget, const std::atomic<bool> *stopFlag = nullptr);
+
+    // Every attempt (and hedge) then takes a slot from limiter and reports back to it.
+    void setRateLimiter(std::shared_ptr<AdaptiveLimiter> limiter);
+
+    // Returns the body of the first successful attempt. Throws std::runtime_error when
+    // the error is not retryable, attempts or retry budget run out, or the job is stopped.
+    // label tags the request in traces and error messages (e.g. "vision"); costTokens is
+    // charged against the limiter's tokens-per-minute bucket.
+    QByteArray post(const QNetworkRequest &request, const QByteArray &body, const QString &label,
+                    double costTokens = 0);
+
+    // Same, but the body is streamed from a device made by makeBody for each attempt
+    // and hedge (concurrent sends cannot share a read position). The reply owns it.
+    using BodyFactory = std::function<QIODevice *()>;
+    QByteArray post(const QNetworkRequest &request, const BodyFactory &makeBody, const QString &label,
+                    double costTokens = 0);
+
+    // GET with the same retries, deadlines and rate limiting.
+    QByteArray get(const QNetworkRequest &request, const QString &label);
+
+private:
+    using Sender = std::function<QNetworkReply *(const QNetworkRequest &)>;
+
+    QByteArray postWith(const QNetworkRequest &request, const Sender &sender, const QString &label,
+                        double costTokens);
+    HttpResult attempt(const QNetworkRequest &request, const Sender &sender, const QString &label,
+                       double costTokens);
+    void sleepFor(int ms);
+
+    QNetworkAccessManager *netman_;
+    RetryPolicy policy_;
+    std::shared_ptr<RetryBudget> budget_;
+    std::shared_ptr<AdaptiveLimiter> limiter_;
+    const std::atomic<bool> *stopFlag_;
+};
+
+// Retry-After value (delta-seconds or HTTP-date) in milliseconds; -1 if absent/invalid.
+int parseRetryAfterMs(const QByteArray &value);
+bool isRetryableStatus(int httpStatus);
+// Full-jitter backoff before retry number `retry` (1-based).
+int backoffDelayMs(int retry, const RetryPolicy &policy);
+// How long the provider asks us to hold off, from Retry-After or an exhausted
+// x-ratelimit-remaining-{requests,tokens} with its reset header; -1 if no hint.
+int rateLimitPauseMs(const QNetworkReply *reply);
+
+} // namespace ocr
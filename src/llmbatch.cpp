@@ -0,0 +1,238 @@
+#include "llmbatch.h"
+#include "ratelimiter.h"
+#include "tracing.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+#include <QThread>
+#include <algorithm>
+#include <stdexcept>
+
+namespace ocr {
+
+static const char kCustomIdPrefix[] = "request-";
+
+QByteArray batchInputJsonl(const QList<QJsonObject> &bodies, const QString &url, int firstIndex) {
+    QByteArray jsonl;
+    for (int i = 0; i < bodies.size(); ++i) {
+        QJsonObject line;
+        line["custom_id"] = QString("%1%2").arg(kCustomIdPrefix).arg(firstIndex + i);
+        line["method"] = "POST";
+        line["url"] = url;
+        line["body"] = bodies[i];
+        jsonl += QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n';
+    }
+    return jsonl;
+}
+
+QList<int> BatchResults::missing(int count) const {
+    QList<int> indices;
+    for (int i = 0; i < count; ++i) {
+        if (!outputs.contains(i)) indices << i;
+    }
+    return indices;
+}
+
+void parseBatchOutput(const QByteArray &jsonl, BatchResults *results) {
+    for (const QByteArray &line : jsonl.split('\n')) {
+        if (line.trimmed().isEmpty()) continue;
+        const QJsonObject entry = QJsonDocument::fromJson(line).object();
+        const QString customId = entry.value("custom_id").toString();
+        if (!customId.startsWith(kCustomIdPrefix)) continue;
+        bool ok = false;
+        const int index = customId.mid(int(sizeof(kCustomIdPrefix)) - 1).toInt(&ok);
+        if (!ok || index < 0) continue;
+
+        const QJsonObject response = entry.value("response").toObject();
+        const QJsonObject body = response.value("body").toObject();
+        const int status = response.value("status_code").toInt();
+        if (status == 200) {
+            // Same as a direct call: an answer without choices is empty text.
+            const QJsonArray choices = body.value("choices").toArray();
+            results->outputs[index] =
+                choices.isEmpty() ? QString()
+                                  : choices[0].toObject()["message"].toObject()["content"].toString();
+            results->errors.remove(index);
+            continue;
+        }
+        if (results->outputs.contains(index)) continue;
+        QString message = entry.value("error").toObject().value("message").toString();
+        if (message.isEmpty()) message = body.value("error").toObject().value("message").toString();
+        if (message.isEmpty()) message = status > 0 ? QString("HTTP %1").arg(status) : QString("no response");
+        results->errors[index] = message;
+    }
+}
+
+bool BatchStatus::done() const {
+    return status == "completed" || status == "failed" || status == "expired" || status == "cancelled";
+}
+
+bool BatchStatus::usable() const {
+    // An expired batch still returns the requests it got through.
+    return status == "completed" || status == "expired";
+}
+
+BatchStatus parseBatchStatus(const QJsonObject &batch) {
+    BatchStatus status;
+    status.id = batch.value("id").toString();
+    status.status = batch.value("status").toString();
+    status.outputFileId = batch.value("output_file_id").toString();
+    status.errorFileId = batch.value("error_file_id").toString();
+    const QJsonObject counts = batch.value("request_counts").toObject();
+    status.total = counts.value("total").toInt();
+    status.completed = counts.value("completed").toInt();
+    status.failed = counts.value("failed").toInt();
+    const QJsonArray errors = batch.value("errors").toObject().value("data").toArray();
+    if (!errors.isEmpty()) status.error = errors.first().toObject().value("message").toString();
+    return status;
+}
+
+static QJsonObject jsonObject(const QByteArray &body, const char *what) {
+    const QJsonDocument doc = QJsonDocument::fromJson(body);
+    if (!doc.isObject()) {
+        throw std::runtime_error(QString("Invalid response from the LLM batch API (%1).").arg(what).toStdString());
+    }
+    return doc.object();
+}
+
+LlmBatchClient::LlmBatchClient(QNetworkAccessManager *netman, const LlmProvider &provider, const QString &apiKey,
+                               const RetryPolicy &policy, std::shared_ptr<RetryBudget> budget,
+                               const std::atomic<bool> *stopFlag)
+    : netman_(netman), provider_(provider), apiKey_(apiKey), policy_(policy), budget_(std::move(budget)),
+      stopFlag_(stopFlag) {}
+
+void LlmBatchClient::setRateLimiter(std::shared_ptr<AdaptiveLimiter> limiter) {
+    limiter_ = std::move(limiter);
+}
+
+BatchResults LlmBatchClient::run(const QList<QJsonObject> &bodies, int pollIntervalMs, const Progress &progress) {
+    BatchResults results;
+    const QString url = provider_.chatCompletionsUrl().path();
+    QList<BatchStatus> batches;
+    try {
+        for (int start = 0; start < bodies.size();) {
+            QByteArray jsonl;
+            int end = start;
+            while (end < bodies.size() && end - start < kMaxRequestsPerBatch) {
+                const QByteArray line = batchInputJsonl({bodies[end]}, url, end);
+                if (end > start && jsonl.size() + line.size() > kMaxBatchFileBytes) break;
+                jsonl += line;
+                ++end;
+            }
+            TraceSpan span("llm_batch_submit", "pipeline", QString("requests %1-%2").arg(start + 1).arg(end));
+            batches << create(upload(jsonl));
+            start = end;
+        }
+        for (;;) {
+            const bool allDone = std::all_of(batches.cbegin(), batches.cend(),
+                                             [](const BatchStatus &b) { return b.done(); });
+            if (allDone) break;
+            waitFor(pollIntervalMs);
+            int finished = 0;
+            for (BatchStatus &batch : batches) {
+                if (!batch.done()) batch = poll(batch.id);
+                finished += batch.completed + batch.failed;
+            }
+            if (progress) progress(finished, bodies.size());
+        }
+    } catch (const std::exception &) {
+        // Nobody will collect the answers; don't leave the provider working on them.
+        if (stopFlag_ && stopFlag_->load()) {
+            for (const BatchStatus &batch : batches) {
+                if (!batch.done()) cancel(batch.id);
+            }
+        }
+        throw;
+    }
+
+    for (const BatchStatus &batch : batches) {
+        if (!batch.usable()) {
+            throw std::runtime_error(QString("LLM batch %1 %2%3")
+                                         .arg(batch.id, batch.status,
+                                              batch.error.isEmpty() ? QString() : ": " + batch.error)
+                                         .toStdString());
+        }
+        TraceSpan span("llm_batch_collect", "pipeline", batch.id);
+        if (!batch.outputFileId.isEmpty()) parseBatchOutput(download(batch.outputFileId), &results);
+        if (!batch.errorFileId.isEmpty()) parseBatchOutput(download(batch.errorFileId), &results);
+    }
+    return results;
+}
+
+QNetworkRequest LlmBatchClient::request(const QString &path) const {
+    QNetworkRequest req(provider_.apiUrl(path));
+    provider_.authorize(req, apiKey_);
+    return req;
+}
+
+QByteArray LlmBatchClient::post(const QNetworkRequest &request, const QByteArray &body, bool retry) {
+    RetryPolicy policy = policy_;
+    if (!retry) policy.maxAttempts = 1;
+    HttpClient http(netman_, policy, budget_, retry ? stopFlag_ : nullptr);
+    http.setRateLimiter(limiter_);
+    return http.post(request, body, provider_.name);
+}
+
+QByteArray LlmBatchClient::get(const QNetworkRequest &request) {
+    HttpClient http(netman_, policy_, budget_, stopFlag_);
+    http.setRateLimiter(limiter_);
+    return http.get(request, provider_.name);
+}
+
+QString LlmBatchClient::upload(const QByteArray &jsonl) {
+    const QByteArray boundary = "ocrllm" + QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+    QByteArray body;
+    body += "--" + boundary + "\r\nContent-Disposition: form-data; name=\"purpose\"\r\n\r\nbatch\r\n";
+    body += "--" + boundary +
+            "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"batch.jsonl\"\r\n"
+            "Content-Type: application/jsonl\r\n\r\n";
+    body += jsonl + "\r\n--" + boundary + "--\r\n";
+
+    QNetworkRequest req = request("/files");
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "multipart/form-data; boundary=" + boundary);
+    const QString id = jsonObject(post(req, body), "file upload").value("id").toString();
+    if (id.isEmpty()) throw std::runtime_error("The LLM batch API returned no file id.");
+    return id;
+}
+
+BatchStatus LlmBatchClient::create(const QString &inputFileId) {
+    QJsonObject payload;
+    payload["input_file_id"] = inputFileId;
+    payload["endpoint"] = provider_.chatCompletionsUrl().path();
+    payload["completion_window"] = "24h";
+    QNetworkRequest req = request("/batches");
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    const BatchStatus status =
+        parseBatchStatus(jsonObject(post(req, QJsonDocument(payload).toJson(QJsonDocument::Compact)), "batch"));
+    if (status.id.isEmpty()) throw std::runtime_error("The LLM batch API returned no batch id.");
+    return status;
+}
+
+BatchStatus LlmBatchClient::poll(const QString &batchId) {
+    BatchStatus status = parseBatchStatus(jsonObject(get(request("/batches/" + batchId)), "batch status"));
+    if (status.id.isEmpty()) status.id = batchId;
+    return status;
+}
+
+QByteArray LlmBatchClient::download(const QString &fileId) {
+    return get(request("/files/" + fileId + "/content"));
+}
+
+void LlmBatchClient::cancel(const QString &batchId) {
+    try {
+        post(request("/batches/" + batchId + "/cancel"), QByteArray(), false);
+    } catch (const std::exception &) {
+        // Best effort; the batch expires on its own.
+    }
+}
+
+void LlmBatchClient::waitFor(int ms) {
+    for (int waited = 0; waited < ms; waited += 50) {
+        if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
+        QThread::msleep(std::min(50, ms - waited));
+    }
+    if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
+}
+
+} // namespace ocr
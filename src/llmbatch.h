@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "httpclient.h"
+#include "llmproviders.h"
+
+class QNetworkAccessManager;
+
+namespace ocr {
+
+class AdaptiveLimiter;
+
+// The input file of an OpenAI-style batch: one line per chat completion body,
+// {"custom_id": "request-<i>", "method": "POST", "url": url, "body": ...}, i from 0.
+QByteArray batchInputJsonl(const QList<QJsonObject> &bodies, const QString &url, int firstIndex = 0);
+
+// Answers read back from batch output (and error) files, by request index.
+struct BatchResults {
+    QMap<int, QString> outputs; // assistant message of each request that succeeded
+    QMap<int, QString> errors;  // why a request failed
+
+    // Requests of 0..count-1 with no answer, in order.
+    QList<int> missing(int count) const;
+};
+
+// Adds the lines of an output or error file to results. Lines for unknown custom_ids
+// are ignored; a request that failed keeps the error unless another line answers it.
+void parseBatchOutput(const QByteArray &jsonl, BatchResults *results);
+
+// The fields of a batch object the client acts on.
+struct BatchStatus {
+    QString id;
+    QString status;       // validating, in_progress, finalizing, completed, failed, expired, ...
+    QString outputFileId;
+    QString errorFileId;
+    int total = 0;
+    int completed = 0;
+    int failed = 0;
+    QString error;        // first entry of "errors", if any
+
+    bool done() const;    // no further change is coming
+    bool usable() const;  // done, and the output files can be read (completed or expired)
+};
+BatchStatus parseBatchStatus(const QJsonObject &batch);
+
+// Runs chat completions through a provider's batch API instead of one request each:
+// the bodies are written as JSONL, uploaded to /files, submitted to /batches and polled
+// until the provider has worked through them, usually at a fraction of the price.
+// Jobs over the provider's per-batch limits are split into several batches submitted
+// together. Must be used on the thread that owns netman.
+class LlmBatchClient {
+public:
+    static constexpr int kMaxRequestsPerBatch = 50000;
+    static constexpr qint64 kMaxBatchFileBytes = 190ll << 20;
+
+    LlmBatchClient(QNetworkAccessManager *netman, const LlmProvider &provider, const QString &apiKey,
+                   const RetryPolicy &policy, std::shared_ptr<RetryBudget> budget,
+                   const std::atomic<bool> *stopFlag = nullptr);
+
+    void setRateLimiter(std::shared_ptr<AdaptiveLimiter> limiter);
+
+    // Called after every poll with the requests finished so far across all batches.
+    using Progress = std::function<void(int finished, int total)>;
+
+    // Submits bodies and waits for their answers, polling every pollIntervalMs. Requests
+    // the provider could not answer are left in BatchResults::errors for the caller to
+    // retry. Throws std::runtime_error when a batch cannot be submitted, fails as a
+    // whole, or the job is stopped (the batches are then cancelled).
+    BatchResults run(const QList<QJsonObject> &bodies, int pollIntervalMs, const Progress &progress = {});
+
+private:
+    QNetworkRequest request(const QString &path) const;
+    QByteArray post(const QNetworkRequest &request, const QByteArray &body, bool retry = true);
+    QByteArray get(const QNetworkRequest &request);
+    QString upload(const QByteArray &jsonl);
+    BatchStatus create(const QString &inputFileId);
+    BatchStatus poll(const QString &batchId);
+    QByteArray download(const QString &fileId);
+    void cancel(const QString &batchId);
+    void waitFor(int ms);
+
+    QNetworkAccessManager *netman_;
+    LlmProvider provider_;
+    QString apiKey_;
+    RetryPolicy policy_;
+    std::shared_ptr<RetryBudget> budget_;
+    std::shared_ptr<AdaptiveLimiter> limiter_;
+    const std::atomic<bool> *stopFlag_;
+};
+
+} // namespace ocr
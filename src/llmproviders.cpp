@@ -0,0 +1,120 @@
+#include "llmproviders.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QStandardPaths>
+#include <stdexcept>
+
+namespace ocr {
+
+QUrl LlmProvider::chatCompletionsUrl() const {
+    return apiUrl("/chat/completions");
+}
+
+QUrl LlmProvider::apiUrl(const QString &path) const {
+    QString base = baseUrl.trimmed();
+    while (base.endsWith('/')) base.chop(1);
+    return QUrl(base + path);
+}
+
+QString LlmProvider::label() const {
+    return QString("%1: %2").arg(name, model);
+}
+
+void LlmProvider::authorize(QNetworkRequest &request, const QString &apiKey) const {
+    if (!needsApiKey()) return;
+    const QString key = apiKeyEnv.isEmpty() ? apiKey : qEnvironmentVariable(apiKeyEnv.toUtf8().constData());
+    if (key.isEmpty()) {
+        throw std::runtime_error(apiKeyEnv.isEmpty()
+                                     ? "LLM API key required."
+                                     : QString("LLM API key required (set %1).").arg(apiKeyEnv).toStdString());
+    }
+    if (auth == "header") {
+        request.setRawHeader(authHeader.toUtf8(), key.toUtf8());
+    } else {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(key).toUtf8());
+    }
+}
+
+QList<LlmProvider> builtinLlmProviders(const Endpoints &endpoints) {
+    LlmProvider openAi;
+    openAi.name = "OpenAI";
+    openAi.baseUrl = endpoints.openAiBaseUrl;
+    openAi.model = "gpt-4o";
+    openAi.batchApi = true;
+
+    LlmProvider openRouter;
+    openRouter.name = "OpenRouter";
+    openRouter.baseUrl = endpoints.openRouterBaseUrl;
+    openRouter.model = "deepseek/deepseek-chat";
+    return {openAi, openRouter};
+}
+
+QList<LlmProvider> loadLlmProviders(const QString &path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error(QString("Failed to open LLM provider file %1.").arg(path).toStdString());
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &parseError);
+    if (!doc.isObject()) {
+        throw std::runtime_error(
+            QString("Invalid LLM provider file %1: %2").arg(path, parseError.errorString()).toStdString());
+    }
+
+    QList<LlmProvider> providers;
+    for (const QJsonValue &value : doc.object().value("providers").toArray()) {
+        const QJsonObject o = value.toObject();
+        LlmProvider p;
+        p.name = o.value("name").toString().trimmed();
+        p.baseUrl = o.value("baseUrl").toString().trimmed();
+        p.auth = o.value("auth").toString("bearer").toLower();
+        p.authHeader = o.value("authHeader").toString();
+        p.apiKeyEnv = o.value("apiKeyEnv").toString();
+        p.model = o.value("model").toString().trimmed();
+        p.maxContextTokens = o.value("maxContextTokens").toInt();
+        p.maxOutputTokens = o.value("maxOutputTokens").toInt();
+        p.maxConcurrency = o.value("maxConcurrency").toInt();
+        p.batchApi = o.value("batchApi").toBool();
+        if (p.name.isEmpty() || p.baseUrl.isEmpty() || p.model.isEmpty()) {
+            throw std::runtime_error(
+                QString("LLM provider entries in %1 need name, baseUrl and model.").arg(path).toStdString());
+        }
+        if (p.auth != "bearer" && p.auth != "none" && !(p.auth == "header" && !p.authHeader.isEmpty())) {
+            throw std::runtime_error(
+                QString("LLM provider %1: auth must be \"bearer\", \"none\" or \"header\" with authHeader.")
+                    .arg(p.name).toStdString());
+        }
+        providers.append(p);
+    }
+    return providers;
+}
+
+QString defaultLlmProvidersPath() {
+    const QString path = qEnvironmentVariable("OCR_LLM_PROVIDERS_FILE");
+    if (!path.isEmpty()) return path;
+    return QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + "/llm_providers.json";
+}
+
+bool findLlmProvider(const QList<LlmProvider> &providers, const QString &selection,
+                     LlmProvider *out) {
+    const QString wanted = selection.trimmed();
+    for (auto it = providers.crbegin(); it != providers.crend(); ++it) {
+        if (wanted == it->name || wanted == it->label()) {
+            *out = *it;
+            return true;
+        }
+        // Model names may contain ':' themselves (e.g. "llama3:8b"), so match the name.
+        if (wanted.startsWith(it->name + ':')) {
+            *out = *it;
+            const QString model = wanted.mid(it->name.size() + 1).trimmed();
+            if (!model.isEmpty()) out->model = model;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace ocr
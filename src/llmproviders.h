@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QUrl>
+#include "endpoints.h"
+
+class QNetworkRequest;
+
+namespace ocr {
+
+// An OpenAI-compatible chat completions service: a hosted API or a local inference
+// server (llama.cpp, vLLM, Ollama, ...).
+struct LlmProvider {
+    QString name;               // shown in the UI and used for its rate limiter
+    QString baseUrl;            // up to and including the version, e.g. "http://localhost:8080/v1"
+    QString auth = "bearer";    // "bearer", "header" (key in authHeader) or "none"
+    QString authHeader;         // e.g. "api-key" for Azure OpenAI
+    QString apiKeyEnv;          // read the key from this variable instead of the UI
+    QString model;
+    int maxContextTokens = 0;   // 0 = known limits for the model name (see modelLimits)
+    int maxOutputTokens = 0;
+    int maxConcurrency = 0;     // 0 = the default rate limits
+    bool batchApi = false;      // takes JSONL batches through /files and /batches (bulk mode)
+
+    QUrl chatCompletionsUrl() const;
+    // baseUrl + path, e.g. apiUrl("/batches").
+    QUrl apiUrl(const QString &path) const;
+    // "Name: model", as listed in the UI.
+    QString label() const;
+    bool needsApiKey() const { return auth != "none"; }
+    // Adds the credentials to request. apiKey is the UI key, used unless apiKeyEnv is
+    // set. Throws std::runtime_error if a key is needed and there is none.
+    void authorize(QNetworkRequest &request, const QString &apiKey) const;
+};
+
+// OpenAI and OpenRouter, at the base URLs in endpoints.
+QList<LlmProvider> builtinLlmProviders(const Endpoints &endpoints);
+
+// Reads provider definitions from a JSON file:
+//   {"providers": [{"name": "Local", "baseUrl": "http://localhost:8080/v1", "auth": "none",
+//                   "model": "qwen2.5-7b-instruct", "maxContextTokens": 32768,
+//                   "maxConcurrency": 4, "batchApi": false}]}
+// Throws std::runtime_error if the file cannot be read or a provider lacks name,
+// baseUrl or model.
+QList<LlmProvider> loadLlmProviders(const QString &path);
+
+// OCR_LLM_PROVIDERS_FILE, or llm_providers.json in the app's config directory.
+QString defaultLlmProvidersPath();
+
+// The provider named by selection, either a name ("Local") or "Name: model" to use
+// another model of it; later entries of providers win over earlier ones of the same
+// name. Returns false if no provider matches.
+bool findLlmProvider(const QList<LlmProvider> &providers, const QString &selection,
+                     LlmProvider *out);
+
+} // namespace ocr
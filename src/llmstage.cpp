@@ -0,0 +1,284 @@
+#include "llmstage.h"
+#include "connectionpool.h"
+#include "llmbatch.h"
+#include "ratelimiter.h"
+#include "textquality.h"
+#include "tracing.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNetworkRequest>
+#include <QStringList>
+#include <QThread>
+#include <stdexcept>
+
+namespace ocr {
+
+LlmThreads::LlmThreads(int threads, const QUrl &url) : url_(url), workers_(qMax(1, threads)) {}
+
+LlmThreads::~LlmThreads() {
+    {
+        QMutexLocker lock(&mutex_);
+        closing_ = true;
+        changed_.wakeAll();
+    }
+    for (Worker &worker : workers_) {
+        if (!worker.thread) continue;
+        worker.thread->wait();
+        delete worker.thread;
+    }
+}
+
+void LlmThreads::preconnect() {
+    const QUrl url = url_;
+    for (int w = 0; w < threadCount(); ++w) post(w, [url]() { ocr::preconnect({url}); });
+}
+
+void LlmThreads::run(int count, const std::function<void(QNetworkAccessManager *)> &task) {
+    count = qBound(0, count, threadCount());
+    QMutex doneMutex;
+    QWaitCondition allDone;
+    int remaining = count;
+    for (int w = 0; w < count; ++w) {
+        post(w, [&]() {
+            task(threadNetworkManager());
+            QMutexLocker lock(&doneMutex);
+            --remaining;
+            allDone.wakeAll();
+        });
+    }
+    QMutexLocker lock(&doneMutex);
+    while (remaining > 0) allDone.wait(&doneMutex);
+}
+
+void LlmThreads::post(int worker, std::function<void()> task) {
+    QMutexLocker lock(&mutex_);
+    Worker &w = workers_[worker];
+    w.tasks.push_back(std::move(task));
+    if (!w.thread) {
+        w.thread = QThread::create([this, worker]() { loop(worker); });
+        w.thread->setObjectName(QString("LLM %1").arg(worker + 1));
+        w.thread->start();
+    }
+    changed_.wakeAll();
+}
+
+void LlmThreads::loop(int worker) {
+    for (;;) {
+        std::function<void()> task;
+        {
+            QMutexLocker lock(&mutex_);
+            std::deque<std::function<void()>> &tasks = workers_[worker].tasks;
+            while (!closing_ && tasks.empty()) changed_.wait(&mutex_);
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+LlmStage::LlmStage(const LlmSettings &settings, const std::atomic<bool> *stopFlag)
+    : settings_(settings), stopFlag_(stopFlag), normalizer_(settings.normalization, settings.provider.model),
+      chunker_(settings.chunkTokenBudget, settings.provider.model) {}
+
+void LlmStage::addPage(int pageNumber, const QString &text, int confidence, double dictionaryHitRate,
+                       bool failed) {
+    TraceSpan span("chunk", "pipeline", QString("page %1").arg(pageNumber));
+    if (failed) {
+        // Nothing for the LLM to correct.
+        passThrough(text);
+        return;
+    }
+    if (settings_.qualityGate > 0) {
+        const TextQuality quality =
+            assessTextQuality(text, settings_.expectedScripts, confidence, dictionaryHitRate);
+        if (quality.score >= settings_.qualityGate) {
+            passThrough(text);
+            ++cleanPages_;
+            return;
+        }
+    }
+    if (!settings_.normalize) {
+        queue(chunker_.addPage(text, pageNumber));
+        return;
+    }
+    // The normalizer holds back a few pages to spot running headers.
+    TraceSpan normalizeSpan("normalize", "pipeline", QString("page %1").arg(pageNumber));
+    queue(normalizer_.addPage(text, pageNumber));
+}
+
+void LlmStage::queue(const QVector<TextChunk> &chunks) {
+    for (const TextChunk &chunk : chunks) {
+        segments_.append({int(batches_.size()), QString()});
+        batches_.append(chunk);
+    }
+}
+
+void LlmStage::queue(const QVector<NormalizedPage> &pages) {
+    for (const NormalizedPage &page : pages) queue(chunker_.addPage(page.text, page.pageNumber));
+}
+
+void LlmStage::passThrough(const QString &text) {
+    // Close the pending run so no batch spans across this page.
+    closeRun();
+    if (segments_.isEmpty() || segments_.last().batch >= 0) segments_.append({-1, text});
+    else segments_.last().text += "\n\n" + text;
+}
+
+void LlmStage::closeRun() {
+    queue(normalizer_.finish());
+    queue(chunker_.finish());
+}
+
+QString LlmStage::batchInfo(int batch) const {
+    return QString("(Batch %1 of %2)").arg(batch + 1).arg(batches_.size());
+}
+
+QString LlmStage::run(const Progress &progress) {
+    closeRun();
+    const int batchCount = batches_.size();
+    QStringList answers(batchCount);
+    if (progress && tokensBefore() > 0) {
+        progress(QString("Local cleanup saved about %1 of %2 tokens").arg(tokensSaved()).arg(tokensBefore()), 0);
+    }
+    QList<int> pending; // batches still needing a direct call
+    for (int i = 0; i < batchCount; ++i) pending << i;
+    if (settings_.bulk && batchCount > 0) pending = runBulk(&answers, progress);
+
+    // Batches are spread over up to maxConcurrency threads; the provider's
+    // AdaptiveLimiter decides how many of them actually have a request in flight. The
+    // threads are normally the processor's, already connected since the job started.
+    std::shared_ptr<LlmThreads> threads = settings_.threads;
+    if (!threads && !pending.isEmpty()) {
+        threads = std::make_shared<LlmThreads>(settings_.maxConcurrency, settings_.provider.chatCompletionsUrl());
+        threads->preconnect();
+    }
+    std::atomic<int> nextBatch(0);
+    std::atomic<int> doneBatches(0);
+    QMutex errorMutex;
+    QString firstError;
+    auto llmLoop = [&](QNetworkAccessManager *netman) {
+        for (;;) {
+            const int next = nextBatch.fetch_add(1);
+            if (next >= pending.size() || (stopFlag_ && stopFlag_->load())) return;
+            const int i = pending[next];
+            {
+                QMutexLocker lock(&errorMutex);
+                if (!firstError.isEmpty()) return;
+            }
+            try {
+                answers[i] = call(i, netman);
+            } catch (const std::exception &ex) {
+                QMutexLocker lock(&errorMutex);
+                if (firstError.isEmpty()) firstError = QString::fromStdString(ex.what());
+                return;
+            }
+            const int done = ++doneBatches;
+            if (progress) {
+                progress(QString("Calling LLM (batch %1/%2)").arg(done).arg(pending.size()),
+                         double(done) / pending.size());
+            }
+        }
+    };
+
+    if (!pending.isEmpty()) threads->run(qMin(int(pending.size()), qMax(1, settings_.maxConcurrency)), llmLoop);
+    checkStopped();
+    if (!firstError.isEmpty()) throw std::runtime_error(firstError.toStdString());
+
+    QStringList parts;
+    for (const Segment &segment : segments_) {
+        parts << (segment.batch >= 0 ? answers[segment.batch] : segment.text);
+    }
+    return parts.join("\n\n---\n\n");
+}
+
+QList<int> LlmStage::runBulk(QStringList *answers, const Progress &progress) {
+    const int batchCount = batches_.size();
+    const LlmProvider &provider = settings_.provider;
+    if (!provider.batchApi) {
+        if (progress) progress(QString("%1 has no batch API; calling it directly").arg(provider.name), 0);
+        return BatchResults().missing(batchCount);
+    }
+    QList<QJsonObject> bodies;
+    for (int i = 0; i < batchCount; ++i) bodies << payload(batches_[i].text, batchInfo(i));
+    LlmBatchClient bulk(threadNetworkManager(), provider, settings_.apiKey, settings_.retryPolicy,
+                        settings_.retryBudget, stopFlag_);
+    bulk.setRateLimiter(settings_.limiter);
+    if (progress) {
+        progress(QString("Submitted %1 batches to the %2 batch API; waiting for results")
+                     .arg(batchCount).arg(provider.name), 0);
+    }
+    BatchResults results;
+    {
+        TraceSpan span("llm_bulk", "pipeline", QString("%1 batches").arg(batchCount));
+        results = bulk.run(bodies, settings_.bulkPollSeconds * 1000, [&](int finished, int total) {
+            if (progress) {
+                progress(QString("LLM batch job: %1/%2 done").arg(finished).arg(total),
+                         double(finished) / qMax(1, total));
+            }
+        });
+    }
+    for (auto it = results.outputs.cbegin(); it != results.outputs.cend(); ++it) {
+        if (it.key() < batchCount) (*answers)[it.key()] = it.value();
+    }
+    const QList<int> missing = results.missing(batchCount);
+    if (!missing.isEmpty() && progress) {
+        progress(QString("%1 of %2 batches failed in the batch job (%3); calling them directly")
+                     .arg(missing.size()).arg(batchCount).arg(results.errors.value(missing.first(), "no answer")),
+                 1);
+    }
+    return missing;
+}
+
+QString LlmStage::call(int batch, QNetworkAccessManager *netman) {
+    const QString info = batchInfo(batch);
+    TraceSpan span("llm_call", "pipeline", info);
+    const LlmProvider &provider = settings_.provider;
+    const QUrl url = provider.chatCompletionsUrl();
+    if (!url.isValid()) throw std::runtime_error("Unsupported LLM provider.");
+    QNetworkRequest req(url);
+    provider.authorize(req, settings_.apiKey);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    const QJsonObject body = payload(batches_[batch].text, info);
+    // Charge the input plus an output of about the same size to the tokens/min bucket.
+    const QString userContent = body["messages"].toArray().last().toObject()["content"].toString();
+    const double costTokens = 2.0 * estimateTokens(userContent, provider.model);
+    HttpClient http(netman, settings_.retryPolicy, settings_.retryBudget, stopFlag_);
+    http.setRateLimiter(settings_.limiter);
+    const QByteArray resp = http.post(req, QJsonDocument(body).toJson(), provider.name, costTokens);
+
+    const QJsonDocument doc = QJsonDocument::fromJson(resp);
+    if (!doc.isObject()) throw std::runtime_error("Invalid response from LLM API.");
+    const QJsonArray choices = doc.object()["choices"].toArray();
+    if (choices.isEmpty()) return QString();
+    return choices[0].toObject()["message"].toObject()["content"].toString();
+}
+
+QJsonObject LlmStage::payload(const QString &text, const QString &batchInfo) const {
+    QJsonObject systemMsg;
+    systemMsg["role"] = "system";
+    systemMsg["content"] = "You are an expert assistant.";
+
+    QJsonObject userMsg;
+    userMsg["role"] = "user";
+    userMsg["content"] = QString("%1\n\nPlease process the following text content %2:\n\n---\n%3\n---")
+                             .arg(settings_.prompt, batchInfo, text);
+
+    QJsonArray messages;
+    messages.append(systemMsg);
+    messages.append(userMsg);
+
+    QJsonObject body;
+    body["model"] = settings_.provider.model;
+    body["messages"] = messages;
+    return body;
+}
+
+void LlmStage::checkStopped() const {
+    if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
+}
+
+} // namespace ocr
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <QChar>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "httpclient.h"
+#include "llmproviders.h"
+#include "textchunker.h"
+#include "textnormalizer.h"
+
+class QNetworkAccessManager;
+class QThread;
+
+namespace ocr {
+
+class AdaptiveLimiter;
+
+// Threads LLM requests are sent from, each with its threadNetworkManager(). Kept across
+// jobs (like the Vision engine) so their keep-alive connections and HTTP/2 sessions are
+// too. Threads start on first use and are joined on destruction.
+class LlmThreads {
+public:
+    LlmThreads(int threads, const QUrl &url);
+    ~LlmThreads();
+
+    LlmThreads(const LlmThreads &) = delete;
+    LlmThreads &operator=(const LlmThreads &) = delete;
+
+    int threadCount() const { return int(workers_.size()); }
+    QUrl url() const { return url_; }
+
+    // Has every thread open a connection to url; returns at once.
+    void preconnect();
+    // Runs task on the first count threads at once, each with its manager, and waits
+    // for all of them. task must not throw.
+    void run(int count, const std::function<void(QNetworkAccessManager *)> &task);
+
+private:
+    struct Worker {
+        QThread *thread = nullptr;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void post(int worker, std::function<void()> task);
+    void loop(int worker);
+
+    QUrl url_;
+    QMutex mutex_;
+    QWaitCondition changed_;
+    std::vector<Worker> workers_;
+    bool closing_ = false;
+};
+
+// What a job's LLM pass needs, fixed when the job starts.
+struct LlmSettings {
+    LlmProvider provider;
+    QString apiKey;
+    QString prompt;
+    int chunkTokenBudget = 0;              // estimated tokens of page text per request
+    double qualityGate = 0;                // pages scoring this (0-1) skip the LLM; 0 = off
+    QList<QChar::Script> expectedScripts;  // scripts of the job's language, for the score
+    bool normalize = true;                 // clean the text up locally before chunking
+    NormalizationOptions normalization;
+    RetryPolicy retryPolicy;
+    std::shared_ptr<RetryBudget> retryBudget;
+    std::shared_ptr<AdaptiveLimiter> limiter;
+    int maxConcurrency = 1;                // threads with a request in flight at most
+    std::shared_ptr<LlmThreads> threads;   // long-lived senders; unset, run() makes its own
+    bool bulk = false;                     // through the provider's batch API, if it has one
+    int bulkPollSeconds = 60;
+};
+
+// The LLM half of a job. Pages are added in page order as OCR delivers them, cleaned up
+// locally and packed into batches straight away, so no whole-document split is needed
+// later; run() then sends the batches and assembles the document. Pages that already
+// read cleanly (with a quality gate) and failure placeholders are passed through
+// untouched, and no batch spans across them.
+class LlmStage {
+public:
+    LlmStage(const LlmSettings &settings, const std::atomic<bool> *stopFlag = nullptr);
+
+    // confidence and dictionaryHitRate as in OcrOutcome (-1 if unknown); failed marks
+    // text as a failure placeholder.
+    void addPage(int pageNumber, const QString &text, int confidence = -1, double dictionaryHitRate = -1,
+                 bool failed = false);
+
+    // Called as batches come back, with a status line and the share done (0-1).
+    using Progress = std::function<void(const QString &status, double done)>;
+
+    // Sends the batches on up to maxConcurrency of settings.threads and returns the answers
+    // and the passed-through text in page order, separated by "\n\n---\n\n". In bulk mode they
+    // go to the batch API first and only what it could not answer is called directly.
+    // Throws std::runtime_error with the first failed request's error, or when stopped.
+    QString run(const Progress &progress = {});
+
+    int batchCount() const { return batches_.size(); }
+    // Pages the quality gate let through without an LLM call.
+    int cleanPages() const { return cleanPages_; }
+    // Estimated tokens the local cleanup removed, of those it saw.
+    int tokensSaved() const { return normalizer_.tokensSaved(); }
+    int tokensBefore() const { return normalizer_.tokensBefore(); }
+
+    // The chat completion body sent for one batch.
+    QJsonObject payload(const QString &text, const QString &batchInfo) const;
+
+private:
+    struct Segment {
+        int batch = -1; // index into batches_, or -1 for passed-through text
+        QString text;
+    };
+
+    void queue(const QVector<TextChunk> &chunks);
+    void queue(const QVector<NormalizedPage> &pages);
+    void passThrough(const QString &text);
+    void closeRun();
+    QString batchInfo(int batch) const;
+    QString call(int batch, QNetworkAccessManager *netman);
+    // Answers what the batch API could; returns the batches still to call directly.
+    QList<int> runBulk(QStringList *answers, const Progress &progress);
+    void checkStopped() const;
+
+    LlmSettings settings_;
+    const std::atomic<bool> *stopFlag_;
+    TextNormalizer normalizer_;
+    TextChunker chunker_;
+    QVector<TextChunk> batches_;
+    QVector<Segment> segments_;
+    int cleanPages_ = 0;
+};
+
+} // namespace ocr
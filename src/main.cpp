@@ -8,6 +8,8 @@ int main(int argc, char *argv[])
     QGuiApplication app(argc, argv);
 
     qmlRegisterType<OcrProcessor>("App", 1, 0, "OcrProcessor");
+    qmlRegisterUncreatableType<PageModel>("App", 1, 0, "PageModel",
+                                          "PageModel is provided by OcrProcessor.pages");
 
     QQmlApplicationEngine engine;
     // When building with qt6_add_qml_module the QML files are placed under
@@ -0,0 +1,132 @@
+#include "memorybudget.h"
+#include "tracing.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <stdexcept>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+namespace ocr {
+
+MemoryBudget::Reservation::Reservation(Reservation &&other) noexcept
+    : budget_(other.budget_), bytes_(other.bytes_) {
+    other.budget_ = nullptr;
+    other.bytes_ = 0;
+}
+
+MemoryBudget::Reservation &MemoryBudget::Reservation::operator=(Reservation &&other) noexcept {
+    if (this != &other) {
+        release();
+        budget_ = other.budget_;
+        bytes_ = other.bytes_;
+        other.budget_ = nullptr;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MemoryBudget::Reservation::resize(qint64 bytes) {
+    bytes = std::max<qint64>(0, bytes);
+    if (!budget_ || bytes == bytes_) return;
+    budget_->adjust(bytes - bytes_);
+    bytes_ = bytes;
+}
+
+MemoryBudget::MemoryBudget(qint64 limitBytes) : limit_(std::max<qint64>(0, limitBytes)) {}
+
+void MemoryBudget::setLimit(qint64 limitBytes) {
+    QMutexLocker lock(&mutex_);
+    limit_ = std::max<qint64>(0, limitBytes);
+    changed_.wakeAll();
+}
+
+qint64 MemoryBudget::limit() const {
+    QMutexLocker lock(&mutex_);
+    return limit_;
+}
+
+bool MemoryBudget::fitsLocked(qint64 bytes) const {
+    return limit_ <= 0 || inUse_ + bytes <= limit_ || inUse_ == 0;
+}
+
+MemoryBudget::Reservation MemoryBudget::reserve(qint64 bytes, const std::atomic<bool> *stopFlag,
+                                                const std::function<bool()> &urgent) {
+    bytes = std::max<qint64>(0, bytes);
+    QMutexLocker lock(&mutex_);
+    if (!fitsLocked(bytes)) {
+        TraceSpan span("memory_wait", "pipeline", QString("%1 MB").arg(bytes >> 20));
+        while (!fitsLocked(bytes)) {
+            if (stopFlag && stopFlag->load()) throw std::runtime_error("Process stopped by user.");
+            if (urgent) {
+                // urgent() may take other locks; do not hold ours meanwhile.
+                lock.unlock();
+                const bool now = urgent();
+                lock.relock();
+                if (now) break;
+            }
+            changed_.wait(&mutex_, 50);
+        }
+    }
+    inUse_ += bytes;
+    peak_ = std::max(peak_, inUse_);
+    return Reservation(this, bytes);
+}
+
+MemoryBudget::Reservation MemoryBudget::tryReserve(qint64 bytes) {
+    bytes = std::max<qint64>(0, bytes);
+    QMutexLocker lock(&mutex_);
+    if (!fitsLocked(bytes)) return Reservation();
+    inUse_ += bytes;
+    peak_ = std::max(peak_, inUse_);
+    return Reservation(this, bytes);
+}
+
+void MemoryBudget::adjust(qint64 delta) {
+    QMutexLocker lock(&mutex_);
+    inUse_ = std::max<qint64>(0, inUse_ + delta);
+    peak_ = std::max(peak_, inUse_);
+    if (delta < 0) changed_.wakeAll();
+}
+
+qint64 MemoryBudget::inUse() const {
+    QMutexLocker lock(&mutex_);
+    return inUse_;
+}
+
+qint64 MemoryBudget::peak() const {
+    QMutexLocker lock(&mutex_);
+    return peak_;
+}
+
+void MemoryBudget::wakeAll() {
+    QMutexLocker lock(&mutex_);
+    changed_.wakeAll();
+}
+
+qint64 physicalMemoryBytes() {
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) return static_cast<qint64>(status.ullTotalPhys);
+    return 0;
+#elif defined(Q_OS_UNIX) && defined(_SC_PHYS_PAGES)
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) return 0;
+    return qint64(pages) * pageSize;
+#else
+    return 0;
+#endif
+}
+
+qint64 defaultMemoryBudget() {
+    bool ok = false;
+    const qint64 mb = qEnvironmentVariable("OCR_MEMORY_BUDGET_MB").toLongLong(&ok);
+    if (ok) return std::max<qint64>(0, mb) << 20;
+    return physicalMemoryBytes() / 2;
+}
+
+} // namespace ocr
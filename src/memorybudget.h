@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+
+namespace ocr {
+
+// Byte budget shared by every stage that holds page-sized memory (rendered images,
+// grayscale copies, encoded payloads, response bodies, finished text waiting to be
+// written). A page is admitted with reserve(), which blocks while the budget is spent;
+// later stages of an admitted page resize its reservation without waiting, since
+// finishing the page is what frees memory. Shared by all workers and jobs.
+class MemoryBudget {
+public:
+    class Reservation {
+    public:
+        Reservation() = default;
+        Reservation(Reservation &&other) noexcept;
+        Reservation &operator=(Reservation &&other) noexcept;
+        ~Reservation() { release(); }
+
+        Reservation(const Reservation &) = delete;
+        Reservation &operator=(const Reservation &) = delete;
+
+        // Grows or shrinks the reservation; never blocks, may take the budget past its limit.
+        void resize(qint64 bytes);
+        void grow(qint64 bytes) { resize(bytes_ + bytes); }
+        void release() { resize(0); }
+        qint64 bytes() const { return bytes_; }
+
+    private:
+        friend class MemoryBudget;
+        Reservation(MemoryBudget *budget, qint64 bytes) : budget_(budget), bytes_(bytes) {}
+
+        MemoryBudget *budget_ = nullptr;
+        qint64 bytes_ = 0;
+    };
+
+    // limitBytes <= 0 means unlimited.
+    explicit MemoryBudget(qint64 limitBytes = 0);
+
+    void setLimit(qint64 limitBytes);
+    qint64 limit() const;
+
+    // Blocks until bytes fit under the limit. A request larger than the whole limit is
+    // let through once nothing else is reserved, and any request goes through at once
+    // while urgent() returns true (e.g. for the page everything else is waiting on).
+    // Throws std::runtime_error if stopFlag is raised while waiting.
+    Reservation reserve(qint64 bytes, const std::atomic<bool> *stopFlag = nullptr,
+                        const std::function<bool()> &urgent = {});
+    // Non-blocking: an empty reservation if bytes do not fit.
+    Reservation tryReserve(qint64 bytes);
+
+    qint64 inUse() const;
+    qint64 peak() const;
+
+    // Wakes blocked reserve() calls so they re-check stop flags and urgent().
+    void wakeAll();
+
+private:
+    void adjust(qint64 delta);
+    bool fitsLocked(qint64 bytes) const;
+
+    mutable QMutex mutex_;
+    QWaitCondition changed_;
+    qint64 limit_;
+    qint64 inUse_ = 0;
+    qint64 peak_ = 0;
+};
+
+// OCR_MEMORY_BUDGET_MB if set, otherwise half the physical memory (0 if unknown).
+qint64 defaultMemoryBudget();
+// Installed RAM in bytes, 0 if the platform does not say.
+qint64 physicalMemoryBytes();
+
+} // namespace ocr
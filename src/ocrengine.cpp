@@ -0,0 +1,106 @@
+#include "ocrengine.h"
+#include "tracing.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+namespace ocr {
+
+OcrOutcome OcrEngine::recognize(OcrPage page) {
+    auto result = std::make_shared<std::promise<OcrOutcome>>();
+    std::future<OcrOutcome> outcome = result->get_future();
+    submit(std::move(page), [result](OcrOutcome done) { result->set_value(std::move(done)); });
+    return outcome.get();
+}
+
+QueuedOcrEngine::QueuedOcrEngine(int threads, const QString &threadName)
+    : maxThreads_(std::max(1, threads)), threadName_(threadName) {}
+
+QueuedOcrEngine::~QueuedOcrEngine() {
+    shutdown();
+}
+
+void QueuedOcrEngine::warmUp() {
+    QMutexLocker lock(&mutex_);
+    if (threads_.empty() && !closing_) startThreadLocked();
+}
+
+void QueuedOcrEngine::submit(OcrPage page, Completion done) {
+    QMutexLocker lock(&mutex_);
+    if (closing_) throw std::runtime_error("OCR engine is shutting down.");
+    queue_.push_back({std::move(page), std::move(done)});
+    // A thread per page waiting, up to the limit; idle ones are reused first.
+    if (int(queue_.size()) > idle_ && int(threads_.size()) < maxThreads_) startThreadLocked();
+    queued_.wakeOne();
+}
+
+void QueuedOcrEngine::startThreadLocked() {
+    const int worker = int(threads_.size());
+    QThread *th = QThread::create([this, worker]() { workerLoop(worker); });
+    th->setObjectName(QString("%1 %2").arg(threadName_).arg(worker + 1));
+    threads_.push_back(th);
+    th->start();
+}
+
+void QueuedOcrEngine::shutdown() {
+    std::vector<QThread *> threads;
+    {
+        QMutexLocker lock(&mutex_);
+        closing_ = true;
+        threads.swap(threads_);
+        queued_.wakeAll();
+    }
+    for (QThread *th : threads) {
+        th->wait();
+        delete th;
+    }
+}
+
+void QueuedOcrEngine::workerLoop(int worker) {
+    startWorker(worker);
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker lock(&mutex_);
+            ++idle_;
+            while (queue_.empty() && !closing_) queued_.wait(&mutex_);
+            --idle_;
+            if (queue_.empty()) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        OcrOutcome outcome;
+        try {
+            TraceSpan span("ocr", "pipeline", QString("%1 page %2").arg(threadName_).arg(job.page.pageNumber));
+            outcome = read(job.page, worker);
+        } catch (const std::exception &ex) {
+            outcome = OcrOutcome();
+            outcome.error = QString::fromStdString(ex.what());
+        } catch (...) {
+            outcome = OcrOutcome();
+            outcome.error = "Unknown OCR engine error.";
+        }
+        outcome.pageNumber = job.page.pageNumber;
+        // Let go of the input before the caller recycles the buffers behind it.
+        job.page = OcrPage();
+        job.done(std::move(outcome));
+    }
+}
+
+EngineChoice engineChoice(const QString &name) {
+    EngineChoice choice;
+    if (name == "Tesseract") {
+        choice.primary = EngineKind::Tesseract;
+    } else if (name == "Google Vision") {
+        choice.primary = EngineKind::Vision;
+    } else if (name == "Tesseract + Vision") {
+        choice.primary = EngineKind::Tesseract;
+        choice.fallback = EngineKind::Vision;
+    }
+    return choice;
+}
+
+} // namespace ocr
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "outputformats.h"
+
+struct Pix;
+class QThread;
+
+namespace ocr {
+
+class RetryBudget;
+
+// How a page is handed to an engine.
+enum class PixelFormat {
+    Gray8, // 8 bpp Leptonica Pix at the render resolution
+    Png,   // encoded PNG bytes
+};
+
+// What an engine wants from the scheduler feeding it.
+struct EngineCapabilities {
+    QString name;
+    int maxBatchSize = 1;         // pages taken per request
+    int preferredConcurrency = 1; // pages in flight that keep the engine busy
+    bool cpuBound = true;         // false: mostly waits on the network
+    QList<PixelFormat> pixelFormats; // accepted, most preferred first
+    qint64 workingBytes = 0;      // held per page while it is read, beyond its input
+
+    bool accepts(PixelFormat format) const { return pixelFormats.contains(format); }
+};
+
+// One page for an engine. Only the field matching a format the engine accepts is
+// set; the caller keeps gray alive until the page completes.
+struct OcrPage {
+    int pageNumber = 0;
+    Pix *gray = nullptr;
+    QByteArray png;
+    QString language;     // Tesseract code, e.g. "hin"
+    QString languageHint; // ISO code, e.g. "hi"
+    QList<OutputFormat> formats; // extra formats to return besides the text
+    int dpi = 300;               // render resolution, for the formats
+    // The submitting job's stop flag and retry budget, for engines that outlive jobs;
+    // unset, the engine's own are used.
+    const std::atomic<bool> *stopFlag = nullptr;
+    std::shared_ptr<RetryBudget> retryBudget;
+};
+
+struct OcrOutcome {
+    int pageNumber = 0;
+    QString text;
+    int confidence = -1;           // mean word confidence 0-100, -1 if the engine has none
+    double dictionaryHitRate = -1; // -1 if unknown
+    QString error;                 // set when the page could not be read
+    QMap<OutputFormat, QByteArray> renderings; // the page in each requested text format
+    PageLayout layout;                         // word boxes, when Pdf was requested
+
+    bool ok() const { return error.isEmpty(); }
+};
+
+// An OCR backend. Pages are submitted without waiting and completed on the engine's
+// own threads, so a scheduler can keep several engines busy at once and size its
+// pipeline from capabilities() instead of knowing which backend it drives.
+class OcrEngine {
+public:
+    using Completion = std::function<void(OcrOutcome)>;
+
+    virtual ~OcrEngine() = default;
+
+    virtual EngineCapabilities capabilities() const = 0;
+
+    // Called when a job starts, before its first page (e.g. to open connections).
+    virtual void warmUp() {}
+
+    // Queues page and returns; done is called exactly once, on an engine thread, with
+    // the text or the error. It must not throw.
+    virtual void submit(OcrPage page, Completion done) = 0;
+
+    // Submits page and waits for its outcome.
+    OcrOutcome recognize(OcrPage page);
+};
+
+// Engine that reads pages one at a time on up to `threads` threads of its own,
+// started as pages arrive. Subclasses implement read(); their destructors must call
+// shutdown() before tearing down anything read() uses.
+class QueuedOcrEngine : public OcrEngine {
+public:
+    ~QueuedOcrEngine() override;
+
+    // Starts the first thread ahead of the first page, so its startWorker() overlaps
+    // the job's set-up.
+    void warmUp() override;
+    void submit(OcrPage page, Completion done) override;
+
+protected:
+    QueuedOcrEngine(int threads, const QString &threadName);
+
+    // Reads page on engine thread `worker` (0-based, stable for the thread's life).
+    // Throws std::runtime_error when the page cannot be read.
+    virtual OcrOutcome read(const OcrPage &page, int worker) = 0;
+    // Runs on each engine thread before its first page.
+    virtual void startWorker(int /*worker*/) {}
+
+    // Finishes the queued pages and joins the threads.
+    void shutdown();
+
+    int threadCount() const { return maxThreads_; }
+
+private:
+    struct Job {
+        OcrPage page;
+        Completion done;
+    };
+
+    void startThreadLocked();
+    void workerLoop(int worker);
+
+    QMutex mutex_;
+    QWaitCondition queued_;
+    std::deque<Job> queue_;
+    std::vector<QThread *> threads_;
+    int maxThreads_;
+    int idle_ = 0;
+    bool closing_ = false;
+    QString threadName_;
+};
+
+// The engines a UI choice runs: primary reads every page and fallback, if any,
+// re-reads the pages primary is unsure of.
+enum class EngineKind { None, Tesseract, Vision };
+struct EngineChoice {
+    EngineKind primary = EngineKind::None;
+    EngineKind fallback = EngineKind::None;
+
+    bool uses(EngineKind kind) const { return primary == kind || fallback == kind; }
+};
+
+// "Tesseract", "Google Vision" or "Tesseract + Vision"; primary is None for anything else.
+EngineChoice engineChoice(const QString &name);
+
+} // namespace ocr
@@ -1,7 +1,6 @@
 #include "OcrProcessor.h"
 #include <QFile>
-#include <QStandardPaths>
-#include <QDir>
+#include <QPdfDocument>
 #include <QImage>
 #include <QPainter>
 #include <QDebug>
@@ -10,19 +9,42 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QCryptographicHash>
 #include <QNetworkReply>
-#include <QEventLoop>
 #include <QFileInfo>
+#include <QScopeGuard>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QWaitCondition>
 #include <tesseract/baseapi.h>
 #include <leptonica/allheaders.h>
 #include <stdexcept>
-#include <openssl/pem.h>
-#include <openssl/evp.h>
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
-#include <openssl/err.h>
-#include <ctime>
+#include <memory>
+#include "tracing.h"
+#include "endpoints.h"
+#include "textchunker.h"
+#include "llmstage.h"
+#include "textnormalizer.h"
+#include "textquality.h"
+#include "ocrengine.h"
+#include "tesseractengine.h"
+#include "visionengine.h"
+#include "ocrprofile.h"
+#include "threadbudget.h"
+#include "pagebuffers.h"
+#include "memorybudget.h"
+#include "pagefailures.h"
+#include "outputformats.h"
+#include "tokenprovider.h"
+#include "httpclient.h"
+#include "ratelimiter.h"
+#include "connectionpool.h"
+#include "visionrequest.h"
+#include "utils.h"
+#include <QMutexLocker>
+#include <map>
+#include <optional>
+#include <vector>
 
 // -----------------------------------------------------------------------------
 // Worker object: performs heavy OCR/LLM work on a background thread.
@@ -35,184 +57,444 @@ public:
                             const QString &ocrEngine,
                             const QString &langKey,
                             const QString &apiKey,
-                            const QString &oauthToken,
                             const QString &googleServiceAccountPath,
                             const QString &prompt,
                             const QMap<QString, QPair<QString, QString>> &langMap,
+                            const ocr::RetryPolicy &retryPolicy,
+                            std::shared_ptr<ocr::OcrEngine> visionEngine,
+                            int cascadeThreshold,
+                            const QString &ocrProfile,
+                            int intraPageThreads,
+                            int totalThreads,
+                            bool pinThreads,
+                            std::shared_ptr<ocr::PageBufferPool> pageBuffers,
+                            std::shared_ptr<ocr::MemoryBudget> memoryBudget,
                             int startPage,
                             int endPage,
-                            std::atomic<bool> *stopFlag)
+                            bool rerunFailedPages,
+                            const QList<ocr::OutputFormat> &outputFormats,
+                            const std::optional<ocr::LlmSettings> &llm,
+                            std::shared_ptr<std::atomic<bool>> stopFlag)
                     : pdfPath_(pdfPath), outputPath_(outputPath), tessPath_(tessPath),
                         ocrEngine_(ocrEngine), langKey_(langKey), apiKey_(apiKey),
-                        oauthToken_(oauthToken), googleServiceAccountPath_(googleServiceAccountPath), 
-                        prompt_(prompt), langMap_(langMap), startPage_(startPage), endPage_(endPage), stopFlag_(stopFlag) {}
+                        googleServiceAccountPath_(googleServiceAccountPath), 
+                        prompt_(prompt), langMap_(langMap), retryPolicy_(retryPolicy),
+                        retryBudget_(std::make_shared<ocr::RetryBudget>(retryPolicy)),
+                        visionEngine_(std::move(visionEngine)), cascadeThreshold_(cascadeThreshold), ocrProfile_(ocr::ocrProfile(ocrProfile)), intraPageThreads_(intraPageThreads), totalThreads_(totalThreads), pinThreads_(pinThreads), pageBuffers_(std::move(pageBuffers)), memoryBudget_(std::move(memoryBudget)), startPage_(startPage), endPage_(endPage), rerunFailedPages_(rerunFailedPages), outputFormats_(outputFormats), llm_(llm), stopFlag_(std::move(stopFlag)) {}
 
 signals:
     void progressChanged(QString, double);
     void finished(QString);
     void errorOccurred(QString);
+    void pageFailed(int page, QString error);
+    // Per-page progress for the PageModel; state is a PageModel::State.
+    void pagesPlanned(QList<int> pages);
+    void pageStateChanged(int page, int state);
+    void pageFinished(int page, QString text, int confidence, qint64 renderMs, qint64 ocrMs);
 
 public slots:
     void process() {
+        ocr::TraceSpan jobSpan("job", "job", ocrEngine_);
         try {
             emit progressChanged("Loading PDF...", 2);
+            const ocr::EngineChoice choice = ocr::engineChoice(ocrEngine_);
+            if (choice.primary == ocr::EngineKind::None) throw std::runtime_error("Unknown OCR engine");
             QPdfDocument doc;
-            if (doc.load(pdfPath_) != QPdfDocument::Error::None) {
-                throw std::runtime_error("Failed to open PDF");
+            {
+                ocr::TraceSpan span("load_pdf");
+                if (doc.load(pdfPath_) != QPdfDocument::Error::None) {
+                    throw std::runtime_error("Failed to open PDF");
+                }
             }
 
             int totalPages = doc.pageCount();
-            int s = (startPage_ >= 1) ? startPage_ : 1;
-            int e = (endPage_ >= 1) ? endPage_ : totalPages;
+            QList<int> pages; // 1-based page numbers, in output order
+            QString previousOutput;
+            if (rerunFailedPages_) {
+                // Only the pages an earlier run left placeholders for.
+                QFile in(outputPath_);
+                if (!in.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                    throw std::runtime_error("Failed to open the existing output to re-run failed pages.");
+                }
+                previousOutput = QString::fromUtf8(in.readAll());
+                for (const ocr::PageFailure &failure : ocr::findFailedPages(previousOutput)) {
+                    if (failure.page >= 1 && failure.page <= totalPages && !pages.contains(failure.page)) {
+                        pages << failure.page;
+                    }
+                }
+                if (pages.isEmpty()) {
+                    emit progressChanged("Done (no failed pages to re-run)", 100);
+                    emit finished(outputPath_);
+                    return;
+                }
+            } else {
+                int s = (startPage_ >= 1) ? startPage_ : 1;
+                int e = (endPage_ >= 1) ? endPage_ : totalPages;
 
-            if (s < 1) s = 1;
-            if (e > totalPages) e = totalPages;
-            if (s > e) {
-                throw std::runtime_error("Invalid page range");
+                if (s < 1) s = 1;
+                if (e > totalPages) e = totalPages;
+                if (s > e) {
+                    throw std::runtime_error("Invalid page range");
+                }
+                for (int page = s; page <= e; ++page) pages << page;
             }
 
-            QStringList images;
-            for (int i = s - 1; i < e; ++i) {
-                if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
-                emit progressChanged(QString("Rendering page %1/%2...").arg(i - (s - 1) + 1).arg(e - (s - 1)), 5);
-                
-                QSizeF pageSize = doc.pagePointSize(i);
-                const double dpi = 300.0;
-                double scale = dpi / 72.0;
-                int w = static_cast<int>(pageSize.width() * scale);
-                int h = static_cast<int>(pageSize.height() * scale);
-                QImage image = doc.render(i, QSize(w, h));
-                if (image.isNull()) throw std::runtime_error("Failed to render PDF page");
-                
-                QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/qt_tess_tmp";
-                QDir().mkpath(tempDir);
-                QString fname = QString("%1/page_%2.png").arg(tempDir).arg(i);
-                if (!image.save(fname, "PNG")) throw std::runtime_error("Failed to save rendered page");
-                images.append(fname);
+            // Written to a temporary file as pages complete in order; only a finished job
+            // replaces outputPath_. A re-run collects its pages and splices them in at the end.
+            QSaveFile outf(outputPath_);
+            if (!outf.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                throw std::runtime_error("Failed to open output file for writing.");
             }
-
-            // Perform OCR
-            emit progressChanged("Performing OCR...", 20);
-            QStringList ocrResults;
-            auto langPair = langMap_.value(langKey_, qMakePair(QString("eng"), QString("en")));
-            QString tessLang = langPair.first;
-            if (!tessLang.contains("eng")) {
-                if (tessLang.isEmpty()) tessLang = "eng";
-                else tessLang = tessLang + "+eng";
+            QMap<int, QString> recoveredPages;
+            // hOCR, TSV, ALTO and the searchable PDF come from the same pass and are
+            // streamed beside the text output in page order; a re-run writes only the text.
+            const QList<ocr::OutputFormat> extraFormats =
+                rerunFailedPages_ ? QList<ocr::OutputFormat>() : outputFormats_;
+            std::vector<std::unique_ptr<ocr::OutputWriter>> writers;
+            const QString pdfFont = extraFormats.contains(ocr::OutputFormat::Pdf) && !tessdataDir().isEmpty()
+                                        ? tessdataDir() + "/pdf.ttf"
+                                        : QString();
+            for (ocr::OutputFormat format : extraFormats) {
+                const QString path = ocr::outputFormatPath(outputPath_, format);
+                const QString canonical = QFileInfo(path).canonicalFilePath();
+                if (!canonical.isEmpty() && (canonical == QFileInfo(pdfPath_).canonicalFilePath() ||
+                                             canonical == QFileInfo(outputPath_).canonicalFilePath())) {
+                    throw std::runtime_error(QString("The %1 output would overwrite %2; choose another output name.")
+                                                 .arg(ocr::outputFormatName(format), path).toStdString());
+                }
+                writers.push_back(std::make_unique<ocr::OutputWriter>(
+                    format, path, QFileInfo(pdfPath_).completeBaseName(), pdfFont));
             }
+            // With an LLM the text goes to the LLM stage in page order instead, and the
+            // output is written once its answers are in. A re-run splices its pages in as read.
+            std::optional<ocr::LlmStage> llm;
+            if (llm_ && !rerunFailedPages_) {
+                ocr::LlmSettings settings = *llm_;
+                settings.retryBudget = retryBudget_;
+                // Its threads connect to the provider while the pages are read.
+                if (settings.threads) settings.threads->preconnect();
+                llm.emplace(settings, stopFlag_.get());
+            }
+            emit pagesPlanned(pages);
+
+            // Render and OCR. The job's engines read pages on threads of their own; a few
+            // render workers keep them fed, rendering straight into recycled buffers (never
+            // temp files) in the format each engine takes. A page holds a memory budget
+            // reservation from before it is rendered until its text has been written. A
+            // page that fails is recorded and replaced by a placeholder; the others carry on.
+            emit progressChanged("Performing OCR...", 5);
+            const int pageCount = pages.size();
+            QMutex renderMutex; // QPdfDocument is not thread-safe
+            // Tesseract is about to start OpenMP; plan with the limit it will read
+            // (none unless set, leaving it the cores the pages cannot use).
+            const int openMpThreads = choice.uses(ocr::EngineKind::Tesseract) ? ocr::freezeOpenMpThreadLimit()
+                                                                               : ocr::openMpThreadLimit();
+            const ocr::ThreadBudget budget = ocr::planThreads(
+                totalThreads_, pageCount, intraPageThreads_,
+                openMpThreads, pinThreads_);
+            std::shared_ptr<ocr::OcrEngine> primary = createEngine(choice.primary, budget);
+            std::shared_ptr<ocr::OcrEngine> fallback = createEngine(choice.fallback, budget);
+            // Vision threads open their connections while the first pages render.
+            primary->warmUp();
+            if (fallback) fallback->warmUp();
+            const ocr::EngineCapabilities primaryCaps = primary->capabilities();
+            std::atomic<int> nextPage(0);
+            std::atomic<int> donePages(0);
+            std::atomic<int> fallbackPages(0);
+            QMutex errorMutex;
+            QString firstError;
+            QList<ocr::PageFailure> failures;
+            auto langPair = langMap_.value(langKey_, qMakePair(QString("eng"), QString("en")));
 
-            for (int i = 0; i < images.size(); ++i) {
-                if (stopFlag_ && stopFlag_->load()) {
-                    // Clean up temp files before stopping
-                    for (const QString &img : images) {
-                        QFile::remove(img);
-                    }
-                    throw std::runtime_error("Process stopped by user.");
-                }
-                
-                emit progressChanged(QString("OCR page %1/%2...").arg(i + 1).arg(images.size()), 
-                                   20 + ((i + 1.0) / images.size()) * 30);
+            // Pages finishing ahead of an earlier one wait here, with their reservations.
+            struct PendingPage {
                 QString text;
-                
-                if (ocrEngine_ == "Tesseract") {
-                    tesseract::TessBaseAPI api;
-                    const char *datapath = tessPath_.isEmpty() ? nullptr : tessPath_.toUtf8().constData();
-                    if (api.Init(datapath, tessLang.toUtf8().constData())) {
-                        // Clean up before throwing
-                        for (const QString &img : images) {
-                            QFile::remove(img);
+                std::optional<ocr::PageRendering> rendering; // unset for failed pages
+                ocr::MemoryBudget::Reservation memory;
+                int confidence = -1;
+                double dictionaryHitRate = -1;
+                bool failed = false;
+            };
+            QMutex outputMutex;
+            std::map<int, PendingPage> pendingOutput;
+            std::atomic<int> nextToWrite(0);
+            auto deliver = [&](int i, PendingPage pending) {
+                QMutexLocker lock(&outputMutex);
+                pendingOutput.emplace(i, std::move(pending));
+                const int before = nextToWrite.load();
+                while (!pendingOutput.empty() && pendingOutput.begin()->first == nextToWrite.load()) {
+                    auto it = pendingOutput.begin();
+                    const int page = pages[it->first];
+                    if (rerunFailedPages_) {
+                        recoveredPages.insert(page, it->second.text);
+                    } else {
+                        if (llm) {
+                            llm->addPage(page, it->second.text, it->second.confidence,
+                                         it->second.dictionaryHitRate, it->second.failed);
+                        } else {
+                            ocr::TraceSpan span("file_write", "pipeline", QString("page %1").arg(page));
+                            const QByteArray bytes = (it->first > 0 ? "\n\n" : "") + it->second.text.toUtf8();
+                            if (outf.write(bytes) != bytes.size()) {
+                                throw std::runtime_error("Failed to write output file.");
+                            }
+                        }
+                        if (it->second.rendering) {
+                            for (const auto &writer : writers) writer->addPage(*it->second.rendering);
                         }
-                        throw std::runtime_error("Could not initialize tesseract");
                     }
-                    Pix *image = pixRead(images[i].toUtf8().constData());
-                    if (!image) { 
-                        api.End(); 
-                        for (const QString &img : images) {
-                            QFile::remove(img);
+                    pendingOutput.erase(it);
+                    ++nextToWrite;
+                }
+                // The next page in line may be waiting for memory; it goes ahead regardless.
+                if (nextToWrite.load() != before) memoryBudget_->wakeAll();
+            };
+
+            // A page from the moment a render worker claims it until its text is delivered;
+            // completions run on engine threads.
+            struct PageJob {
+                int index = 0;
+                int page = 0;
+                QImage image;
+                std::optional<ocr::PageBufferPool::Lease> buffer;
+                ocr::MemoryBudget::Reservation memory;
+                QElapsedTimer clock;
+                qint64 renderMs = 0;
+            };
+            QMutex flightMutex;
+            QWaitCondition flightDone;
+            int startedPages = 0;
+            int finishedPages = 0;
+
+            auto finishPage = [&](const std::shared_ptr<PageJob> &job, const ocr::OcrOutcome &outcome,
+                                  bool usedFallback) {
+                if (!(stopFlag_ && stopFlag_->load())) {
+                    PendingPage pending;
+                    QString &text = pending.text;
+                    std::optional<ocr::PageRendering> &rendering = pending.rendering;
+                    if (outcome.ok()) {
+                        text = outcome.text;
+                        pending.confidence = outcome.confidence;
+                        pending.dictionaryHitRate = outcome.dictionaryHitRate;
+                        if (usedFallback) ++fallbackPages;
+                        if (!extraFormats.isEmpty()) {
+                            ocr::TraceSpan span("render_outputs", "pipeline", QString("page %1").arg(job->page));
+                            rendering.emplace();
+                            rendering->pageNumber = job->page;
+                            rendering->dpi = kRenderDpi;
+                            rendering->imageSize = job->image.size();
+                            rendering->layout = outcome.layout;
+                            rendering->fragments = outcome.renderings;
+                            if (extraFormats.contains(ocr::OutputFormat::Pdf)) {
+                                rendering->jpeg = ocr::pageImageJpeg(job->image, &rendering->grayscale);
+                            }
                         }
-                        throw std::runtime_error("Failed to read image"); 
+                        emit pageFinished(job->page, text, outcome.confidence, job->renderMs,
+                                          job->clock.elapsed());
+                    } else {
+                        {
+                            QMutexLocker lock(&errorMutex);
+                            failures.append({job->page, outcome.error});
+                        }
+                        emit pageFailed(job->page, outcome.error);
+                        text = ocr::failurePlaceholder(job->page, outcome.error);
+                        pending.failed = true;
                     }
-                    api.SetImage(image); 
-                    api.Recognize(0);
-                    char *out = api.GetUTF8Text();
-                    if (out) { 
-                        text = QString::fromUtf8(out); 
-                        delete[] out; 
+                    // Only the text and its renderings wait for the output; the page itself is done with.
+                    job->image = QImage();
+                    job->buffer.reset();
+                    try {
+                        job->memory.resize(text.size() * qint64(sizeof(QChar)) +
+                                           (rendering ? rendering->bytes() : 0));
+                        pending.memory = std::move(job->memory);
+                        deliver(job->index, std::move(pending));
+                        const int done = ++donePages;
+                        emit progressChanged(QString("OCR page %1/%2...").arg(done).arg(pageCount),
+                                             5 + (double(done) / pageCount) * 45);
+                    } catch (const std::exception &ex) {
+                        QMutexLocker lock(&errorMutex);
+                        if (firstError.isEmpty()) firstError = QString::fromStdString(ex.what());
                     }
-                    pixDestroy(&image); 
-                    api.End();
-                } else if (ocrEngine_ == "Google Vision") {
-                    // Google Vision implementation
-                    QFile f(images[i]); 
-                    if (!f.open(QIODevice::ReadOnly)) throw std::runtime_error("Failed to open image");
-                    QByteArray bytes = f.readAll(); 
-                    f.close();
-                    QString base64 = QString::fromLatin1(bytes.toBase64());
-                    
-                    QJsonObject imageObj; 
-                    imageObj["content"] = base64;
-                    QJsonObject feature; 
-                    feature["type"] = "DOCUMENT_TEXT_DETECTION";
-                    QJsonArray features; 
-                    features.append(feature);
-                    QJsonObject request; 
-                    request["image"] = imageObj; 
-                    request["features"] = features;
-                    QJsonArray requests; 
-                    requests.append(request);
-                    QJsonObject payload; 
-                    payload["requests"] = requests;
-
-                    QNetworkAccessManager netman;
-                    QNetworkRequest req;
-                    if (!oauthToken_.isEmpty()) {
-                        req.setUrl(QUrl("https://vision.googleapis.com/v1/images:annotate"));
-                        req.setRawHeader("Authorization", QString("Bearer %1").arg(oauthToken_).toUtf8());
-                    } else {
-                        throw std::runtime_error("Service account usage not available in this worker path");
+                }
+                job->memory.release();
+                QMutexLocker lock(&flightMutex);
+                ++finishedPages;
+                flightDone.wakeAll();
+            };
+
+            // Hands job's page to engine in a format it accepts, growing the page's
+            // reservation for each copy and for what the engine holds while reading it.
+            auto submitTo = [&](ocr::OcrEngine &engine, const std::shared_ptr<PageJob> &job,
+                                ocr::OcrEngine::Completion done) {
+                const ocr::EngineCapabilities caps = engine.capabilities();
+                const qint64 pixels = qint64(job->image.width()) * job->image.height();
+                ocr::PageBuffer &buffer = **job->buffer;
+                ocr::OcrPage input;
+                input.pageNumber = job->page;
+                input.language = langPair.first;
+                input.languageHint = langPair.second;
+                input.formats = extraFormats;
+                input.dpi = kRenderDpi;
+                input.stopFlag = stopFlag_.get();
+                input.retryBudget = retryBudget_;
+                if (caps.accepts(ocr::PixelFormat::Gray8)) {
+                    ocr::TraceSpan span("preprocess", "pipeline", QString("page %1").arg(job->page));
+                    job->memory.grow(pixels); // 8 bpp copy
+                    input.gray = buffer.grayPix(job->image, kRenderDpi);
+                    if (!input.gray) throw std::runtime_error("Failed to convert rendered page");
+                } else if (caps.accepts(ocr::PixelFormat::Png)) {
+                    ocr::TraceSpan span("encode", "pipeline", QString("page %1").arg(job->page));
+                    // A scanned page rarely compresses worse than a byte per pixel.
+                    const qint64 before = job->memory.bytes();
+                    job->memory.grow(pixels);
+                    input.png = buffer.png(job->image);
+                    job->memory.resize(before + input.png.size());
+                } else {
+                    throw std::runtime_error(
+                        QString("%1 takes no page format this pipeline produces").arg(caps.name).toStdString());
+                }
+                job->memory.grow(caps.workingBytes);
+                emit pageStateChanged(job->page, PageModel::Recognizing);
+                engine.submit(std::move(input), std::move(done));
+            };
+
+            // Pages in flight on the primary engine: what keeps it busy, plus one being
+            // rendered per render worker.
+            const int renderWorkers = qMin(pageCount, primaryCaps.cpuBound
+                                                          ? 2
+                                                          : qMax(2, budget.pageWorkers * budget.blockThreads));
+            QSemaphore primarySlots(primaryCaps.preferredConcurrency * primaryCaps.maxBatchSize + renderWorkers);
+
+            auto onPrimary = [&](const std::shared_ptr<PageJob> &job, ocr::OcrOutcome outcome) {
+                primarySlots.release();
+                // Cascade: only pages the primary engine is unsure about go to the fallback.
+                if (fallback && outcome.ok() && outcome.confidence < cascadeThreshold_ &&
+                    !(stopFlag_ && stopFlag_->load())) {
+                    ocr::TraceSpan span("cascade", "pipeline",
+                                        QString("page %1 conf %2").arg(job->page).arg(outcome.confidence));
+                    try {
+                        submitTo(*fallback, job, [&, job](ocr::OcrOutcome second) { finishPage(job, second, true); });
+                        return;
+                    } catch (const std::exception &ex) {
+                        outcome.error = QString::fromStdString(ex.what());
                     }
-                    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-                    QNetworkReply *reply = netman.post(req, QJsonDocument(payload).toJson());
-                    QEventLoop loop; 
-                    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit); 
-                    loop.exec();
-                    
-                    if (reply->error() != QNetworkReply::NoError) { 
-                        QString err = reply->errorString(); 
-                        reply->deleteLater(); 
-                        for (const QString &img : images) {
-                            QFile::remove(img);
-                        }
-                        throw std::runtime_error(err.toStdString()); 
+                }
+                finishPage(job, outcome, false);
+            };
+
+            auto renderLoop = [&]() {
+                for (;;) {
+                    {
+                        QMutexLocker lock(&errorMutex);
+                        if (!firstError.isEmpty()) return;
+                    }
+                    primarySlots.acquire();
+                    const int i = nextPage.fetch_add(1);
+                    if (i >= pageCount || (stopFlag_ && stopFlag_->load())) {
+                        primarySlots.release();
+                        return;
                     }
-                    
-                    QByteArray resp = reply->readAll(); 
-                    reply->deleteLater(); 
-                    QJsonDocument doc = QJsonDocument::fromJson(resp);
-                    if (!doc.isObject()) throw std::runtime_error("Invalid response from Google Vision.");
-                    
-                    QJsonObject root = doc.object(); 
-                    QJsonArray responses = root["responses"].toArray(); 
-                    if (responses.isEmpty()) { 
-                        text = QString(); 
-                    } else { 
-                        text = responses[0].toObject()["fullTextAnnotation"].toObject()["text"].toString(); 
+                    auto job = std::make_shared<PageJob>();
+                    job->index = i;
+                    job->page = pages[i];
+                    {
+                        QMutexLocker lock(&flightMutex);
+                        ++startedPages;
                     }
+                    try {
+                        QSize size;
+                        {
+                            QMutexLocker lock(&renderMutex);
+                            size = renderSize(doc, job->page - 1);
+                        }
+                        // Pages wait here while the budget is spent, except the one the
+                        // output is waiting for, which would otherwise stall everything.
+                        job->memory = memoryBudget_->reserve(
+                            qint64(size.width()) * size.height() * 4, stopFlag_.get(),
+                            [&]() { return nextToWrite.load() == i; });
+                        emit pageStateChanged(job->page, PageModel::Rendering);
+                        job->clock.start();
+                        {
+                            QMutexLocker lock(&renderMutex);
+                            job->image = renderPage(doc, job->page - 1, size);
+                        }
+                        job->renderMs = job->clock.restart();
+                        job->buffer.emplace(pageBuffers_->acquire());
+                        submitTo(*primary, job, [&, job](ocr::OcrOutcome outcome) { onPrimary(job, std::move(outcome)); });
+                    } catch (const std::exception &ex) {
+                        primarySlots.release();
+                        ocr::OcrOutcome failed;
+                        failed.error = QString::fromStdString(ex.what());
+                        finishPage(job, failed, false);
+                    }
+                }
+            };
+
+            {
+                // Every page started must complete before the state above goes away.
+                auto waitForPages = qScopeGuard([&]() {
+                    QMutexLocker lock(&flightMutex);
+                    while (finishedPages < startedPages) flightDone.wait(&flightMutex);
+                });
+                QList<QThread *> workers;
+                for (int w = 0; w < renderWorkers; ++w) {
+                    QThread *th = QThread::create(renderLoop);
+                    th->setObjectName(QString("OCR render worker %1").arg(w + 1));
+                    workers << th;
+                    th->start();
+                }
+                for (QThread *th : workers) {
+                    th->wait();
+                    delete th;
                 }
-                
-                ocrResults << text;
-                QFile::remove(images[i]);
             }
-
-            QString joined = ocrResults.join("\n\n");
-            QFile outf(outputPath_);
-            if (!outf.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                throw std::runtime_error("Failed to open output file for writing.");
+            if (stopFlag_ && stopFlag_->load()) throw std::runtime_error("Process stopped by user.");
+            if (!firstError.isEmpty()) throw std::runtime_error(firstError.toStdString());
+            // Nothing worth keeping: report the cause rather than a file of placeholders.
+            if (failures.size() == pageCount) {
+                throw std::runtime_error(failures.first().error.toStdString());
+            }
+            if (rerunFailedPages_) {
+                ocr::TraceSpan span("file_write", "pipeline", "splice");
+                const QByteArray bytes = ocr::spliceRecoveredPages(previousOutput, recoveredPages).toUtf8();
+                if (outf.write(bytes) != bytes.size()) {
+                    throw std::runtime_error("Failed to write output file.");
+                }
+            }
+            if (llm) {
+                if (llm->cleanPages() > 0) {
+                    emit progressChanged(QString("%1 of %2 pages read cleanly; sending the rest to the LLM")
+                                             .arg(llm->cleanPages()).arg(pageCount), 60);
+                }
+                const QString text = llm->run([this](const QString &status, double done) {
+                    emit progressChanged(status, 60 + done * 35);
+                });
+                ocr::TraceSpan span("file_write", "pipeline", "llm output");
+                const QByteArray bytes = text.toUtf8();
+                if (outf.write(bytes) != bytes.size()) {
+                    throw std::runtime_error("Failed to write output file.");
+                }
             }
-            outf.write(joined.toUtf8()); 
-            outf.close();
+            for (const auto &writer : writers) writer->commit();
+            if (!outf.commit()) throw std::runtime_error("Failed to write output file.");
 
-            emit progressChanged("Done", 100);
+            QStringList notes;
+            if (fallback) {
+                notes << QString("%1 used on %2 of %3 pages")
+                             .arg(fallback->capabilities().name).arg(fallbackPages.load()).arg(pageCount);
+            }
+            if (!writers.empty()) {
+                QStringList names;
+                for (ocr::OutputFormat format : extraFormats) names << ocr::outputFormatName(format);
+                notes << QString("also wrote %1").arg(names.join(", "));
+            }
+            if (llm_ && rerunFailedPages_) notes << "re-run pages were not sent to the LLM";
+            if (!failures.isEmpty()) {
+                notes << QString("%1 of %2 pages failed; re-run failed pages to retry them")
+                             .arg(failures.size()).arg(pageCount);
+            }
+            emit progressChanged(notes.isEmpty() ? QString("Done")
+                                                 : QString("Done (%1)").arg(notes.join("; ")),
+                                 100);
             emit finished(outputPath_);
             
         } catch (const std::exception &ex) {
@@ -223,93 +505,84 @@ public slots:
     }
 
 private:
+    QString tessdataDir() const {
+#ifdef APP_TESSDATA_DIR
+        return QString(APP_TESSDATA_DIR);
+#else
+        return ocr::findTessdataDir(tessPath_);
+#endif
+    }
+
+    // The job's engine of this kind, or null for EngineKind::None. Tesseract is sized
+    // for the job; Vision is the processor's, kept across jobs.
+    std::shared_ptr<ocr::OcrEngine> createEngine(ocr::EngineKind kind, const ocr::ThreadBudget &budget) {
+        switch (kind) {
+        case ocr::EngineKind::Tesseract:
+            return std::make_shared<ocr::TesseractEngine>(tessdataDir(), ocrProfile_, budget, stopFlag_.get());
+        case ocr::EngineKind::Vision:
+            if (!visionEngine_) throw std::runtime_error("Google Vision is not set up.");
+            return visionEngine_;
+        case ocr::EngineKind::None:
+            break;
+        }
+        return nullptr;
+    }
+
+    static constexpr int kRenderDpi = 300;
+
+    static QSize renderSize(QPdfDocument &doc, int pageIndex) {
+        const QSizeF pageSize = doc.pagePointSize(pageIndex);
+        const double scale = kRenderDpi / 72.0;
+        return QSize(static_cast<int>(pageSize.width() * scale),
+                     static_cast<int>(pageSize.height() * scale));
+    }
+
+    QImage renderPage(QPdfDocument &doc, int pageIndex, const QSize &size) {
+        ocr::TraceSpan span("render", "pipeline", QString("page %1").arg(pageIndex + 1));
+        QImage image = doc.render(pageIndex, size);
+        if (image.isNull()) throw std::runtime_error("Failed to render PDF page");
+        return image;
+    }
+
     QString pdfPath_;
     QString outputPath_;
     QString tessPath_;
     QString ocrEngine_;
     QString langKey_;
     QString apiKey_;
-    QString oauthToken_;
     QString googleServiceAccountPath_;
     QString prompt_;
     QMap<QString, QPair<QString, QString>> langMap_;
+    ocr::RetryPolicy retryPolicy_;
+    std::shared_ptr<ocr::RetryBudget> retryBudget_;
+    std::shared_ptr<ocr::OcrEngine> visionEngine_; // null unless the job uses Vision
+    int cascadeThreshold_;
+    ocr::OcrProfile ocrProfile_;
+    int intraPageThreads_;
+    int totalThreads_;
+    bool pinThreads_;
+    std::shared_ptr<ocr::PageBufferPool> pageBuffers_;
+    std::shared_ptr<ocr::MemoryBudget> memoryBudget_;
     int startPage_;
     int endPage_;
-    std::atomic<bool> *stopFlag_;
+    bool rerunFailedPages_;
+    QList<ocr::OutputFormat> outputFormats_;
+    std::optional<ocr::LlmSettings> llm_; // unset for OCR only
+    std::shared_ptr<std::atomic<bool>> stopFlag_;
 };
 
-// Helper functions
-static QByteArray base64UrlEncode(const QByteArray &input) {
-    QByteArray b = input.toBase64(QByteArray::Base64Encoding);
-    b = b.replace('+', '-').replace('/', '_');
-    while (b.endsWith('=')) b.chop(1);
-    return b;
-}
-
 #include "OcrProcessor.moc"
 
-static QByteArray signWithPrivateKey(const QByteArray &privateKeyPem, const QByteArray &data) {
-    BIO *bio = BIO_new_mem_buf(privateKeyPem.constData(), privateKeyPem.size());
-    if (!bio) return QByteArray();
-    EVP_PKEY *pkey = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
-    BIO_free(bio);
-    if (!pkey) return QByteArray();
-
-    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
-    if (!mdctx) {
-        EVP_PKEY_free(pkey);
-        return QByteArray();
-    }
-
-    if (EVP_DigestSignInit(mdctx, NULL, EVP_sha256(), NULL, pkey) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(pkey);
-        return QByteArray();
-    }
-
-    if (EVP_DigestSignUpdate(mdctx, data.constData(), data.size()) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(pkey);
-        return QByteArray();
-    }
-
-    size_t siglen = 0;
-    if (EVP_DigestSignFinal(mdctx, NULL, &siglen) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(pkey);
-        return QByteArray();
-    }
-
-    unsigned char *sig = (unsigned char *)OPENSSL_malloc(siglen);
-    if (!sig) {
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(pkey);
-        return QByteArray();
-    }
-
-    if (EVP_DigestSignFinal(mdctx, sig, &siglen) != 1) {
-        OPENSSL_free(sig);
-        EVP_MD_CTX_free(mdctx);
-        EVP_PKEY_free(pkey);
-        return QByteArray();
-    }
-
-    QByteArray signature = QByteArray(reinterpret_cast<char*>(sig), (int)siglen);
-    OPENSSL_free(sig);
-    EVP_MD_CTX_free(mdctx);
-    EVP_PKEY_free(pkey);
-    return signature;
-}
-
 OcrProcessor::OcrProcessor(QObject *parent)
     : QObject(parent),
-      pdfDoc_(nullptr),
       startPage_(1),
       endPage_(-1),
       ocrOnly_(false),
       stopFlag_(false),
       workerThread_(nullptr),
-      netman_(new QNetworkAccessManager(this))
+      pageBuffers_(std::make_shared<ocr::PageBufferPool>()),
+      memoryBudget_(std::make_shared<ocr::MemoryBudget>(ocr::defaultMemoryBudget())),
+      pages_(new PageModel(this))
 {
     langMap_ = {
         { "English (eng)", { "eng", "en" } },
@@ -331,20 +604,30 @@ OcrProcessor::OcrProcessor(QObject *parent)
     };
     
     llmProvider_ = "OpenAI: gpt-4o";
+    tracePath_ = qEnvironmentVariable("OCR_TRACE_FILE");
+    endpoints_ = ocr::Endpoints::fromEnvironment();
+
+    // Conservative defaults (Vision's default project quota is 1800 requests/min); the
+    // AIMD window finds the real headroom and setRateLimits() adjusts the caps.
+    ocr::RateLimits visionLimits;
+    visionLimits.requestsPerMinute = 1800;
+    visionLimits.maxConcurrency = 16;
+    visionLimits.initialConcurrency = 4;
+    rateLimits_["vision"] = visionLimits;
+    rateLimits_["OpenAI"] = ocr::RateLimits();
+    rateLimits_["OpenRouter"] = ocr::RateLimits();
+
+    const QString providersPath = ocr::defaultLlmProvidersPath();
+    if (QFileInfo::exists(providersPath)) loadLlmProviders(providersPath);
 }
 
 OcrProcessor::~OcrProcessor() {
-    if (pdfDoc_) {
-        delete pdfDoc_;
-    }
     if (workerThread_) {
+        if (jobStop_) jobStop_->store(true);
         stopFlag_.store(true);
         workerThread_->quit();
-        workerThread_->wait(3000); // Wait up to 3 seconds
-        if (workerThread_->isRunning()) {
-            workerThread_->terminate();
-            workerThread_->wait();
-        }
+        // Recognition and network waits both watch the stop flags, so this is quick.
+        workerThread_->wait();
         delete workerThread_;
     }
 }
@@ -369,6 +652,34 @@ void OcrProcessor::setOcrEngine(const QString &engine) {
     ocrEngine_ = engine;
 }
 
+void OcrProcessor::setCascadeThreshold(int confidence) {
+    cascadeThreshold_ = qBound(0, confidence, 100);
+}
+
+void OcrProcessor::setOcrProfile(const QString &name) {
+    ocrProfile_ = ocr::ocrProfile(name).name;
+}
+
+QStringList OcrProcessor::ocrProfiles() const {
+    return ocr::ocrProfileNames();
+}
+
+void OcrProcessor::setIntraPageThreads(int threads) {
+    intraPageThreads_ = qBound(1, threads, QThread::idealThreadCount());
+}
+
+void OcrProcessor::setThreadBudget(int totalThreads, int openMpThreads, bool pinThreads) {
+    threadBudget_ = qMax(0, totalThreads);
+    pinThreads_ = pinThreads;
+    if (openMpThreads > 0 && !ocr::setOpenMpThreadLimit(openMpThreads)) {
+        qWarning() << "OpenMP threads are fixed once Tesseract has run; keeping" << ocr::openMpThreadLimit();
+    }
+}
+
+void OcrProcessor::setMemoryBudget(int megabytes) {
+    memoryBudget_->setLimit(qint64(qMax(0, megabytes)) << 20);
+}
+
 void OcrProcessor::setLanguage(const QString &langKey) {
     langKey_ = langKey;
 }
@@ -381,107 +692,206 @@ void OcrProcessor::setGoogleServiceAccountPath(const QString &path) {
     googleServiceAccountPath_ = path;
 }
 
-QString OcrProcessor::getAccessTokenFromServiceAccount(const QString &jsonPath) {
-    qint64 now = std::time(nullptr);
-    if (!googleAccessToken_.isEmpty() && googleAccessTokenExpiry_ > now + 60) {
-        return googleAccessToken_;
+std::shared_ptr<ocr::GoogleTokenProvider> OcrProcessor::tokenProviderFor(const QString &jsonPath) {
+    // Reuse the running provider (and its cached key and token) across jobs.
+    if (!tokenProvider_ || tokenProvider_->serviceAccountPath() != jsonPath ||
+        tokenProvider_->tokenUrl() != QUrl(endpoints_.oauthTokenUrl)) {
+        tokenProvider_ = std::make_shared<ocr::GoogleTokenProvider>(jsonPath, QUrl(endpoints_.oauthTokenUrl));
+        tokenProvider_->start();
     }
+    return tokenProvider_;
+}
 
-    QFile f(jsonPath);
-    if (!f.open(QIODevice::ReadOnly)) {
-        throw std::runtime_error("Failed to open service account JSON file.");
-    }
-    QByteArray content = f.readAll();
-    f.close();
+void OcrProcessor::setPrompt(const QString &p) {
+    prompt_ = p;
+}
 
-    QJsonDocument jd = QJsonDocument::fromJson(content);
-    if (!jd.isObject()) {
-        throw std::runtime_error("Invalid service account JSON.");
-    }
-    QJsonObject obj = jd.object();
-    QString client_email = obj.value("client_email").toString();
-    QString private_key = obj.value("private_key").toString();
-    if (client_email.isEmpty() || private_key.isEmpty()) {
-        throw std::runtime_error("Service account JSON missing required fields.");
-    }
+void OcrProcessor::setPageRange(int start, int end) {
+    startPage_ = start;
+    endPage_ = end;
+}
 
-    qint64 iat = std::time(nullptr);
-    qint64 exp = iat + 3600;
+void OcrProcessor::setRerunFailedPages(bool rerun) {
+    rerunFailedPages_ = rerun;
+}
 
-    QJsonObject header;
-    header["alg"] = "RS256";
-    header["typ"] = "JWT";
+void OcrProcessor::setOutputFormats(const QStringList &formats) {
+    outputFormats_ = ocr::parseOutputFormats(formats);
+}
 
-    QJsonObject claim;
-    claim["iss"] = client_email;
-    claim["scope"] = "https://www.googleapis.com/auth/cloud-platform";
-    claim["aud"] = "https://oauth2.googleapis.com/token";
-    claim["exp"] = (double)exp;
-    claim["iat"] = (double)iat;
+QStringList OcrProcessor::outputFormats() const {
+    QStringList names;
+    for (ocr::OutputFormat format : outputFormats_) names << ocr::outputFormatName(format);
+    return names;
+}
 
-    QByteArray headerB = QJsonDocument(header).toJson(QJsonDocument::Compact);
-    QByteArray claimB = QJsonDocument(claim).toJson(QJsonDocument::Compact);
+void OcrProcessor::setTextNormalization(bool enabled, bool stripHeadersFooters,
+                                        bool stripPageNumbers, bool joinHyphenation) {
+    normalizeText_ = enabled;
+    normalization_.stripHeadersFooters = stripHeadersFooters;
+    normalization_.stripPageNumbers = stripPageNumbers;
+    normalization_.joinHyphenation = joinHyphenation;
+}
 
-    QByteArray encodedHeader = base64UrlEncode(headerB);
-    QByteArray encodedClaim = base64UrlEncode(claimB);
-    QByteArray unsignedJwt = encodedHeader + "." + encodedClaim;
+void OcrProcessor::setOcrOnly(bool ocrOnly) {
+    ocrOnly_ = ocrOnly;
+}
 
-    QByteArray signature = signWithPrivateKey(private_key.toUtf8(), unsignedJwt);
-    if (signature.isEmpty()) {
-        throw std::runtime_error("Failed to sign JWT assertion.");
+void OcrProcessor::setLlmProvider(const QString &provider) {
+    llmProvider_ = provider;
+}
+
+bool OcrProcessor::loadLlmProviders(const QString &path) {
+    QList<ocr::LlmProvider> providers;
+    try {
+        providers = ocr::loadLlmProviders(path);
+    } catch (const std::exception &ex) {
+        qWarning() << ex.what();
+        return false;
+    }
+    configuredLlmProviders_ = providers;
+    // A provider's own concurrency cap seeds its limits; setRateLimits() still wins.
+    QMutexLocker lock(&limitersMutex_);
+    for (const ocr::LlmProvider &provider : providers) {
+        if (provider.maxConcurrency <= 0 || rateLimits_.contains(provider.name)) continue;
+        ocr::RateLimits limits;
+        limits.maxConcurrency = provider.maxConcurrency;
+        limits.initialConcurrency = qMin(limits.initialConcurrency, provider.maxConcurrency);
+        rateLimits_[provider.name] = limits;
     }
-    QByteArray encodedSig = base64UrlEncode(signature);
-    QByteArray signedJwt = unsignedJwt + "." + encodedSig;
-
-    QNetworkRequest req(QUrl("https://oauth2.googleapis.com/token"));
-    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-    QByteArray body = QString("grant_type=urn:ietf:params:oauth:grant-type:jwt-bearer&assertion=%1")
-        .arg(QString::fromUtf8(signedJwt)).toUtf8();
-
-    QNetworkReply *reply = netman_->post(req, body);
-    QEventLoop loop;
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    if (reply->error() != QNetworkReply::NoError) {
-        QString err = reply->errorString();
-        reply->deleteLater();
-        throw std::runtime_error(err.toStdString());
+    return true;
+}
+
+QStringList OcrProcessor::llmProviders() const {
+    QStringList labels;
+    QStringList names;
+    const QList<ocr::LlmProvider> providers = allLlmProviders();
+    for (auto it = providers.crbegin(); it != providers.crend(); ++it) {
+        if (names.contains(it->name)) continue;
+        names.prepend(it->name);
+        labels.prepend(it->label());
+    }
+    return labels;
+}
+
+QList<ocr::LlmProvider> OcrProcessor::allLlmProviders() const {
+    // Built-ins are rebuilt so they follow setEndpointBaseUrl().
+    return ocr::builtinLlmProviders(endpoints_) + configuredLlmProviders_;
+}
+
+ocr::LlmProvider OcrProcessor::currentLlmProvider() const {
+    ocr::LlmProvider provider;
+    if (!ocr::findLlmProvider(allLlmProviders(), llmProvider_, &provider)) {
+        throw std::runtime_error("Unsupported LLM provider.");
     }
+    return provider;
+}
 
-    QByteArray resp = reply->readAll();
-    reply->deleteLater();
-    QJsonDocument respDoc = QJsonDocument::fromJson(resp);
-    if (!respDoc.isObject()) {
-        throw std::runtime_error("Invalid token response from OAuth server.");
+void OcrProcessor::setEndpointBaseUrl(const QString &service, const QString &url) {
+    if (!endpoints_.setBaseUrl(service, url)) {
+        qWarning() << "Unknown endpoint service" << service;
     }
-    QJsonObject robj = respDoc.object();
-    QString access_token = robj.value("access_token").toString();
-    int expires_in = robj.value("expires_in").toInt(3600);
-    if (access_token.isEmpty()) {
-        throw std::runtime_error("OAuth token response missing access_token.");
+}
+
+void OcrProcessor::setChunkTokenBudget(int tokens) {
+    chunkTokenBudget_ = tokens;
+}
+
+void OcrProcessor::setLlmQualityGate(double minScore) {
+    llmQualityGate_ = qBound(0.0, minScore, 1.0);
+}
+
+void OcrProcessor::setLlmBulkMode(bool enabled, int pollSeconds) {
+    llmBulk_ = enabled;
+    llmBulkPollSeconds_ = qMax(1, pollSeconds);
+}
+
+void OcrProcessor::setRetryPolicy(int maxAttempts, int timeoutMs, int hedgeAfterMs,
+                                  double retryBudgetRatio) {
+    retryPolicy_.maxAttempts = qMax(1, maxAttempts);
+    retryPolicy_.timeoutMs = qMax(0, timeoutMs);
+    retryPolicy_.hedgeAfterMs = qMax(0, hedgeAfterMs);
+    retryPolicy_.retryBudgetRatio = qMax(0.0, retryBudgetRatio);
+}
+
+void OcrProcessor::setRateLimits(const QString &provider, double requestsPerMinute,
+                                 double tokensPerMinute, int maxConcurrency) {
+    ocr::RateLimits limits = rateLimitsFor(provider);
+    limits.requestsPerMinute = requestsPerMinute;
+    limits.tokensPerMinute = tokensPerMinute;
+    limits.maxConcurrency = qMax(1, maxConcurrency);
+    QMutexLocker lock(&limitersMutex_);
+    rateLimits_[provider] = limits;
+    if (limiters_.contains(provider)) limiters_[provider]->setLimits(limits);
+}
+
+ocr::RateLimits OcrProcessor::rateLimitsFor(const QString &provider) const {
+    QMutexLocker lock(&limitersMutex_);
+    return rateLimits_.value(provider, ocr::RateLimits());
+}
+
+std::shared_ptr<ocr::AdaptiveLimiter> OcrProcessor::limiterFor(const QString &provider) {
+    // Limiters outlive jobs so the learned window carries over to the next run.
+    QMutexLocker lock(&limitersMutex_);
+    auto &limiter = limiters_[provider];
+    if (!limiter) {
+        limiter = std::make_shared<ocr::AdaptiveLimiter>(rateLimits_.value(provider, ocr::RateLimits()));
     }
+    return limiter;
+}
 
-    googleAccessToken_ = access_token;
-    googleAccessTokenExpiry_ = std::time(nullptr) + expires_in;
-    return googleAccessToken_;
+static bool sameVisionSettings(const ocr::VisionSettings &a, const ocr::VisionSettings &b) {
+    return a.endpoints.visionAnnotateUrl() == b.endpoints.visionAnnotateUrl() && a.apiKey == b.apiKey &&
+           a.tokenProvider == b.tokenProvider && a.limiter == b.limiter &&
+           a.retryPolicy.maxAttempts == b.retryPolicy.maxAttempts &&
+           a.retryPolicy.baseDelayMs == b.retryPolicy.baseDelayMs &&
+           a.retryPolicy.maxDelayMs == b.retryPolicy.maxDelayMs &&
+           a.retryPolicy.timeoutMs == b.retryPolicy.timeoutMs &&
+           a.retryPolicy.hedgeAfterMs == b.retryPolicy.hedgeAfterMs &&
+           a.retryPolicy.retryBudgetRatio == b.retryPolicy.retryBudgetRatio &&
+           a.retryPolicy.retryBudgetMin == b.retryPolicy.retryBudgetMin;
 }
 
-void OcrProcessor::setPrompt(const QString &p) {
-    prompt_ = p;
+std::shared_ptr<ocr::OcrEngine> OcrProcessor::visionEngineFor(
+    const std::shared_ptr<ocr::GoogleTokenProvider> &tokenProvider) {
+    ocr::VisionSettings settings;
+    settings.endpoints = endpoints_;
+    settings.apiKey = apiKey_;
+    settings.tokenProvider = tokenProvider;
+    settings.retryPolicy = retryPolicy_;
+    settings.limiter = limiterFor("vision");
+    // Its threads, and their connections, carry over to the next job. New settings (or
+    // a new concurrency cap, which sized the threads) start a fresh engine; the old one
+    // shuts down when the last job using it lets go.
+    const int threads = settings.limiter->limits().maxConcurrency;
+    if (!visionEngine_ || !sameVisionSettings(visionSettings_, settings) || visionThreads_ != threads) {
+        visionEngine_ = std::make_shared<ocr::VisionEngine>(settings);
+        visionSettings_ = settings;
+        visionThreads_ = threads;
+    }
+    return visionEngine_;
 }
 
-void OcrProcessor::setPageRange(int start, int end) {
-    startPage_ = start;
-    endPage_ = end;
+std::shared_ptr<ocr::LlmThreads> OcrProcessor::llmThreadsFor(const ocr::LlmProvider &provider) {
+    // Kept while the endpoint and the concurrency cap stay the same; a job still
+    // using the old threads keeps them until it finishes.
+    const QUrl url = provider.chatCompletionsUrl();
+    const int threads = qMax(1, rateLimitsFor(provider.name).maxConcurrency);
+    if (!llmThreads_ || llmThreads_->url() != url || llmThreads_->threadCount() != threads) {
+        llmThreads_ = std::make_shared<ocr::LlmThreads>(threads, url);
+    }
+    return llmThreads_;
 }
 
-void OcrProcessor::setOcrOnly(bool ocrOnly) {
-    ocrOnly_ = ocrOnly;
+void OcrProcessor::setTracePath(const QString &path) {
+    tracePath_ = path;
 }
 
-void OcrProcessor::setLlmProvider(const QString &provider) {
-    llmProvider_ = provider;
+void OcrProcessor::flushTrace() {
+    if (tracePath_.isEmpty() || !ocr::Tracer::instance().isEnabled()) return;
+    if (!ocr::Tracer::instance().writeTo(tracePath_)) {
+        qWarning() << "Failed to write trace file" << tracePath_;
+    }
 }
 
 void OcrProcessor::startProcessing() {
@@ -507,8 +917,16 @@ void OcrProcessor::startProcessing() {
         return;
     }
     
+    const ocr::EngineChoice engines = ocr::engineChoice(ocrEngine_);
+    if (engines.primary == ocr::EngineKind::None) {
+        emit errorOccurred(QString("Unknown OCR engine: %1").arg(ocrEngine_));
+        return;
+    }
+    const bool usesTesseract = engines.uses(ocr::EngineKind::Tesseract);
+    const bool usesVision = engines.uses(ocr::EngineKind::Vision);
+
     // Tesseract-specific validation
-    if (ocrEngine_ == "Tesseract") {
+    if (usesTesseract) {
         if (tessPath_.isEmpty()) {
             emit errorOccurred("Tesseract path not set. Please specify the location of the Tesseract executable.");
             return;
@@ -532,7 +950,7 @@ void OcrProcessor::startProcessing() {
     }
     
     // Google Vision validation
-    if (ocrEngine_ == "Google Vision") {
+    if (usesVision) {
         if (apiKey_.isEmpty() && googleServiceAccountPath_.isEmpty()) {
             emit errorOccurred("Google Vision requires either an API key or a service account JSON file.");
             return;
@@ -548,8 +966,15 @@ void OcrProcessor::startProcessing() {
     }
     
     // LLM validation
+    ocr::LlmProvider llmProvider;
     if (!ocrOnly_) {
-        if (apiKey_.isEmpty()) {
+        try {
+            llmProvider = currentLlmProvider();
+        } catch (const std::exception &ex) {
+            emit errorOccurred(QString::fromStdString(ex.what()));
+            return;
+        }
+        if (llmProvider.needsApiKey() && llmProvider.apiKeyEnv.isEmpty() && apiKey_.isEmpty()) {
             emit errorOccurred("API key required for LLM processing. Either enter an API key or enable 'OCR Only' mode.");
             return;
         }
@@ -563,73 +988,94 @@ void OcrProcessor::startProcessing() {
         langKey_ = "English (eng)";
     }
 
-    // Stop any existing worker
-    if (workerThread_ && workerThread_->isRunning()) {
-        stopFlag_.store(true);
-        workerThread_->quit();
-        workerThread_->wait(1000);
-        if (workerThread_->isRunning()) {
-            workerThread_->terminate();
-            workerThread_->wait();
-        }
+    std::optional<ocr::LlmSettings> llm;
+    if (!ocrOnly_) {
+        llm.emplace();
+        llm->provider = llmProvider;
+        llm->apiKey = apiKey_;
+        llm->prompt = prompt_;
+        llm->chunkTokenBudget = chunkTokenBudget();
+        llm->qualityGate = llmQualityGate_;
+        llm->expectedScripts = ocr::scriptsForLanguage(langMap_.value(langKey_, qMakePair(QString("eng"), QString("en"))).first);
+        llm->normalize = normalizeText_;
+        llm->normalization = normalization_;
+        llm->retryPolicy = retryPolicy_;
+        llm->limiter = limiterFor(llmProvider.name);
+        llm->maxConcurrency = rateLimitsFor(llmProvider.name).maxConcurrency;
+        llm->threads = llmThreadsFor(llmProvider);
+        llm->bulk = llmBulk_;
+        llm->bulkPollSeconds = llmBulkPollSeconds_;
     }
 
+    // Jobs run one after another on a single long-lived thread, so its network
+    // connections survive from one job to the next. A job still running is asked to
+    // stop; the new one is queued behind it and starts once it has wound down.
+    if (activeWorker_ && jobStop_) {
+        jobStop_->store(true);
+    }
+    jobStop_ = std::make_shared<std::atomic<bool>>(false);
     stopFlag_.store(false);
 
-    if (workerThread_) {
-        delete workerThread_;
-        workerThread_ = nullptr;
+    if (!workerThread_) {
+        workerThread_ = new QThread();
+        workerThread_->setObjectName("OcrWorker");
+        workerThread_->start();
+    }
+    if (!tracePath_.isEmpty()) {
+        ocr::Tracer::instance().start();
     }
-
-    workerThread_ = new QThread();
     
-    QString oauthToken;
-    if (ocrEngine_ == "Google Vision" && apiKey_.isEmpty() && !googleServiceAccountPath_.isEmpty()) {
+    // Only the key file is read here; the token itself is minted on the provider's
+    // thread and the worker waits for it, so the UI never blocks on the network.
+    std::shared_ptr<ocr::GoogleTokenProvider> tokenProvider;
+    if (usesVision && !googleServiceAccountPath_.isEmpty()) {
         try {
-            emit progressChanged("Obtaining Google Cloud access token...", 1);
-            oauthToken = getAccessTokenFromServiceAccount(googleServiceAccountPath_);
+            tokenProvider = tokenProviderFor(googleServiceAccountPath_);
         } catch (const std::exception &ex) {
             emit errorOccurred(QString("Failed to authenticate with Google Cloud: %1").arg(ex.what()));
-            delete workerThread_;
-            workerThread_ = nullptr;
-            return;
-        } catch (...) {
-            emit errorOccurred("Failed to obtain access token from service account.");
-            delete workerThread_;
-            workerThread_ = nullptr;
             return;
         }
     }
 
+    std::shared_ptr<ocr::OcrEngine> visionEngine;
+    if (usesVision) visionEngine = visionEngineFor(tokenProvider);
+
     OcrWorker *worker = new OcrWorker(pdfPath_, outputPath_, tessPath_, ocrEngine_, langKey_, 
-                                      apiKey_, oauthToken, googleServiceAccountPath_, prompt_, 
-                                      langMap_, startPage_, endPage_, &stopFlag_);
+                                      apiKey_, googleServiceAccountPath_, prompt_, 
+                                      langMap_, retryPolicy_,
+                                      visionEngine, cascadeThreshold_, ocrProfile_, intraPageThreads_, threadBudget_, pinThreads_,
+                                      pageBuffers_, memoryBudget_, startPage_, endPage_, rerunFailedPages_, outputFormats_, llm, jobStop_);
     worker->moveToThread(workerThread_);
+    activeWorker_ = worker;
 
     connect(worker, &OcrWorker::progressChanged, this, &OcrProcessor::progressChanged, Qt::QueuedConnection);
+    connect(worker, &OcrWorker::pageFailed, this, &OcrProcessor::pageFailed, Qt::QueuedConnection);
+    connect(worker, &OcrWorker::pagesPlanned, pages_, &PageModel::reset, Qt::QueuedConnection);
+    connect(worker, &OcrWorker::pageStateChanged, pages_, &PageModel::setState, Qt::QueuedConnection);
+    connect(worker, &OcrWorker::pageFinished, pages_, &PageModel::setResult, Qt::QueuedConnection);
+    connect(worker, &OcrWorker::pageFailed, pages_, &PageModel::setFailed, Qt::QueuedConnection);
     connect(worker, &OcrWorker::finished, this, [this, worker](QString out) {
         emit this->finished(out);
-        this->workerThread_->quit();
         worker->deleteLater();
     }, Qt::QueuedConnection);
     connect(worker, &OcrWorker::errorOccurred, this, [this, worker](QString err) {
         emit this->errorOccurred(err);
-        this->workerThread_->quit();
         worker->deleteLater();
     }, Qt::QueuedConnection);
-
-    connect(workerThread_, &QThread::started, worker, &OcrWorker::process);
-    connect(workerThread_, &QThread::finished, workerThread_, &QObject::deleteLater);
-    connect(workerThread_, &QThread::finished, this, [this]() {
+    connect(worker, &QObject::destroyed, this, [this]() {
+        // A job superseded by a newer one stays quiet; the last one to finish reports.
+        // Its spans are all closed once the worker has been destroyed.
+        if (activeWorker_) return;
+        flushTrace();
         emit stopped();
-        this->workerThread_ = nullptr;
     });
-    
-    workerThread_->start();
+
+    QMetaObject::invokeMethod(worker, &OcrWorker::process, Qt::QueuedConnection);
 }
 
 void OcrProcessor::stopProcessing() {
-    if (workerThread_ && workerThread_->isRunning()) {
+    if (activeWorker_) {
+        if (jobStop_) jobStop_->store(true);
         stopFlag_.store(true);
         emitProgress("Stopping...", 0);
     } else {
@@ -637,400 +1083,20 @@ void OcrProcessor::stopProcessing() {
     }
 }
 
-#include "utils.h"
-
-QString OcrProcessor::getTessdataDir() {
-#ifdef APP_TESSDATA_DIR
-    return QString(APP_TESSDATA_DIR);
-#else
-    return ocr::findTessdataDir(tessPath_);
-#endif
-}
-
-QString OcrProcessor::renderPageToTempPNG(int pageIndex) {
-    if (!pdfDoc_) {
-        pdfDoc_ = new QPdfDocument(this);
-        if (pdfDoc_->load(pdfPath_) != QPdfDocument::Error::None) {
-            throw std::runtime_error("Failed to open PDF");
-        }
-    }
-
-    QSizeF pageSize = pdfDoc_->pagePointSize(pageIndex);
-    
-    const double dpi = 300.0;
-    double scale = dpi / 72.0;
-    int w = static_cast<int>(pageSize.width() * scale);
-    int h = static_cast<int>(pageSize.height() * scale);
-
-    QImage image = pdfDoc_->render(pageIndex, QSize(w, h));
-    
-    if (image.isNull()) {
-        throw std::runtime_error("Failed to render PDF page");
-    }
-
-    QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/qt_tess_tmp";
-    QDir().mkpath(tempDir);
-
-    QByteArray nameHash = QCryptographicHash::hash(
-        QString("%1_%2").arg(pdfPath_).arg(pageIndex).toUtf8(),
-        QCryptographicHash::Sha1
-    );
-    QString fname = QString("%1/page_%2_%3.png")
-        .arg(tempDir)
-        .arg(pageIndex)
-        .arg(QString(nameHash.toHex()).left(8));
-    
-    if (!image.save(fname, "PNG")) {
-        throw std::runtime_error("Failed to save rendered page");
-    }
-    
-    return fname;
-}
-
-QString OcrProcessor::runTesseractOnImage(const QString &imagePath, const QString &tessLang, 
-                                         const QString &tessdataDir) {
-    tesseract::TessBaseAPI api;
-    
-    const char *datapath = tessdataDir.isEmpty() ? nullptr : tessdataDir.toUtf8().constData();
-    
-    if (api.Init(datapath, tessLang.toUtf8().constData())) {
-        throw std::runtime_error(
-            QString("Could not initialize tesseract for lang %1 (datapath=%2)")
-            .arg(tessLang, tessdataDir.isEmpty() ? "default" : tessdataDir)
-            .toStdString()
-        );
-    }
-
-    Pix *image = pixRead(imagePath.toUtf8().constData());
-    if (!image) {
-        api.End();
-        throw std::runtime_error("Failed to read image into Leptonica Pix object.");
-    }
-
-    api.SetImage(image);
-    api.Recognize(0);
-    
-    char *out = api.GetUTF8Text();
-    QString result;
-    if (out) {
-        result = QString::fromUtf8(out);
-        delete[] out;
-    }
-    
-    pixDestroy(&image);
-    api.End();
-    
-    return result;
-}
-
-QString OcrProcessor::runGoogleVisionOnImage(const QString &imagePath, const QString &visionLang) {
-    if (apiKey_.isEmpty() && googleServiceAccountPath_.isEmpty()) {
-        throw std::runtime_error("Google Vision requires an API key or a service account JSON file.");
-    }
-    
-    QFile f(imagePath);
-    if (!f.open(QIODevice::ReadOnly)) {
-        throw std::runtime_error("Failed to open rendered image for Vision.");
-    }
-    QByteArray bytes = f.readAll();
-    f.close();
-    
-    QString base64 = QString::fromLatin1(bytes.toBase64());
-
-    QJsonObject imageObj;
-    imageObj["content"] = base64;
-
-    QJsonObject feature;
-    feature["type"] = "DOCUMENT_TEXT_DETECTION";
-
-    QJsonArray features;
-    features.append(feature);
-
-    QJsonObject imageContext;
-    QJsonArray langHints;
-    langHints.append(visionLang);
-    imageContext["languageHints"] = langHints;
-
-    QJsonObject request;
-    request["image"] = imageObj;
-    request["features"] = features;
-    request["imageContext"] = imageContext;
-
-    QJsonArray requests;
-    requests.append(request);
-    
-    QJsonObject payload;
-    payload["requests"] = requests;
-
-    QNetworkRequest netReq;
-    if (!apiKey_.isEmpty()) {
-        netReq.setUrl(QUrl(QString("https://vision.googleapis.com/v1/images:annotate?key=%1").arg(apiKey_)));
-    } else {
-        QString token = getAccessTokenFromServiceAccount(googleServiceAccountPath_);
-        netReq.setUrl(QUrl("https://vision.googleapis.com/v1/images:annotate"));
-        netReq.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
-    }
-    netReq.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-
-    QNetworkReply *reply = netman_->post(netReq, QJsonDocument(payload).toJson());
-    QEventLoop loop;
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    if (reply->error() != QNetworkReply::NoError) {
-        QString err = reply->errorString();
-        reply->deleteLater();
-        throw std::runtime_error(err.toStdString());
-    }
-    
-    QByteArray resp = reply->readAll();
-    reply->deleteLater();
-
-    QJsonDocument doc = QJsonDocument::fromJson(resp);
-    if (!doc.isObject()) {
-        throw std::runtime_error("Invalid response from Google Vision.");
-    }
-    
-    QJsonObject root = doc.object();
-    QJsonArray responses = root["responses"].toArray();
-    if (responses.isEmpty()) {
-        return QString();
-    }
-
-    QJsonObject first = responses[0].toObject();
-    QString fullText = first["fullTextAnnotation"].toObject()["text"].toString();
-    
-    return fullText;
+QString OcrProcessor::llmModel() const {
+    ocr::LlmProvider provider;
+    if (ocr::findLlmProvider(allLlmProviders(), llmProvider_, &provider)) return provider.model;
+    return QString("gpt-4o");
 }
 
-QStringList OcrProcessor::splitTextIntoBatches(const QString &text, int wordsPerBatch) {
-    // QRegExp was removed in Qt6; use QRegularExpression which is the modern API.
-    QStringList words = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-    QStringList batches;
-    
-    for (int i = 0; i < words.size(); i += wordsPerBatch) {
-        int count = qMin(wordsPerBatch, words.size() - i);
-        batches.append(words.mid(i, count).join(" "));
+int OcrProcessor::chunkTokenBudget() const {
+    const QString model = llmModel();
+    ocr::ModelLimits limits = ocr::modelLimits(model);
+    ocr::LlmProvider provider;
+    if (ocr::findLlmProvider(allLlmProviders(), llmProvider_, &provider)) {
+        if (provider.maxContextTokens > 0) limits.contextTokens = provider.maxContextTokens;
+        if (provider.maxOutputTokens > 0) limits.maxOutputTokens = provider.maxOutputTokens;
     }
-    
-    return batches;
+    return ocr::TextChunker::budgetForLimits(limits, ocr::estimateTokens(prompt_, model),
+                                             chunkTokenBudget_);
 }
-
-QString OcrProcessor::callLLM(const QString &textChunk, const QString &batchInfo) {
-    if (apiKey_.isEmpty()) {
-        throw std::runtime_error("LLM API key required.");
-    }
-
-    QJsonObject systemMsg;
-    systemMsg["role"] = "system";
-    systemMsg["content"] = "You are an expert assistant.";
-
-    QJsonObject userMsg;
-    userMsg["role"] = "user";
-    userMsg["content"] = QString("%1\n\nPlease process the following text content %2:\n\n---\n%3\n---")
-        .arg(prompt_, batchInfo, textChunk);
-
-    QJsonArray messages;
-    messages.append(systemMsg);
-    messages.append(userMsg);
-
-    QJsonObject payload;
-    
-    // Parse provider and model
-    QString provider, model;
-    if (llmProvider_.contains(":")) {
-        QStringList parts = llmProvider_.split(":", Qt::SkipEmptyParts);
-        if (parts.size() >= 2) {
-            provider = parts[0].trimmed();
-            model = parts[1].trimmed();
-        }
-    } else {
-        provider = "OpenAI";
-        model = "gpt-4o";
-    }
-
-    payload["model"] = model;
-    payload["messages"] = messages;
-
-    QNetworkRequest req;
-    
-    if (provider == "OpenAI") {
-        req.setUrl(QUrl("https://api.openai.com/v1/chat/completions"));
-        req.setRawHeader("Authorization", QString("Bearer %1").arg(apiKey_).toUtf8());
-    } else if (provider == "OpenRouter") {
-        req.setUrl(QUrl("https://openrouter.ai/api/v1/chat/completions"));
-        req.setRawHeader("Authorization", QString("Bearer %1").arg(apiKey_).toUtf8());
-    } else {
-        throw std::runtime_error("Unsupported LLM provider.");
-    }
-    
-    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-
-    QNetworkReply *reply = netman_->post(req, QJsonDocument(payload).toJson());
-    QEventLoop loop;
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    if (reply->error() != QNetworkReply::NoError) {
-        QString err = reply->errorString();
-        reply->deleteLater();
-        throw std::runtime_error(err.toStdString());
-    }
-    
-    QByteArray resp = reply->readAll();
-    reply->deleteLater();
-
-    QJsonDocument doc = QJsonDocument::fromJson(resp);
-    if (!doc.isObject()) {
-        throw std::runtime_error("Invalid response from LLM API.");
-    }
-    
-    QJsonObject root = doc.object();
-    QJsonArray choices = root["choices"].toArray();
-    if (choices.isEmpty()) {
-        return QString();
-    }
-    
-    QString text = choices[0].toObject()["message"].toObject()["content"].toString();
-    return text;
-}
-
-void OcrProcessor::workerRoutine() {
-    try {
-        emitProgress("Loading PDF...", 2);
-        
-        QPdfDocument doc;
-        if (doc.load(pdfPath_) != QPdfDocument::Error::None) {
-            throw std::runtime_error("Failed to open PDF");
-        }
-        
-        int totalPages = doc.pageCount();
-        int s = (startPage_ >= 1) ? startPage_ : 1;
-        int e = (endPage_ >= 1) ? endPage_ : totalPages;
-        
-        if (s < 1) s = 1;
-        if (e > totalPages) e = totalPages;
-        if (s > e) {
-            throw std::runtime_error("Invalid page range");
-        }
-
-        // Render pages
-        QStringList images;
-        int pageCount = e - s + 1;
-        
-        for (int i = s - 1; i < e; ++i) {
-            if (stopFlag_.load()) {
-                throw std::runtime_error("Process stopped by user.");
-            }
-            
-            double progress = 5 + ((i - (s - 1) + 1.0) / pageCount) * 15;
-            emitProgress(QString("Rendering page %1/%2...").arg(i - (s - 1) + 1).arg(pageCount), progress);
-            
-            QString png = renderPageToTempPNG(i);
-            images.append(png);
-        }
-
-        if (stopFlag_.load()) {
-            throw std::runtime_error("Process stopped by user.");
-        }
-
-        // Perform OCR
-        emitProgress("Performing OCR...", 20);
-        
-        QStringList ocrResults;
-        auto langPair = langMap_.value(langKey_, qMakePair(QString("eng"), QString("en")));
-        QString tessLang = langPair.first;
-        if (!tessLang.contains("eng")) {
-            if (tessLang.isEmpty()) tessLang = "eng";
-            else tessLang = tessLang + "+eng";
-        }
-        QString visionLang = langPair.second;
-        QString tessdataDir = getTessdataDir();
-
-        for (int i = 0; i < images.size(); ++i) {
-            if (stopFlag_.load()) {
-                throw std::runtime_error("Process stopped by user.");
-            }
-            
-            double progress = 20 + ((i + 1.0) / images.size()) * 30;
-            emitProgress(QString("OCR page %1/%2...").arg(i + 1).arg(images.size()), progress);
-            
-            QString imagePath = images[i];
-            QString text;
-            
-            if (ocrEngine_ == "Tesseract") {
-                text = runTesseractOnImage(imagePath, tessLang, tessdataDir);
-            } else if (ocrEngine_ == "Google Vision") {
-                text = runGoogleVisionOnImage(imagePath, visionLang);
-            } else {
-                throw std::runtime_error("Unknown OCR engine");
-            }
-            
-            ocrResults << text;
-            
-            // Clean up temp file
-            QFile::remove(imagePath);
-        }
-
-        if (stopFlag_.load()) {
-            throw std::runtime_error("Process stopped by user.");
-        }
-
-        QString fullText = ocrResults.join("\n\n");
-
-        // If OCR only, save and finish
-        if (ocrOnly_ || prompt_.isEmpty()) {
-            QFile outf(outputPath_);
-            if (!outf.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                throw std::runtime_error("Failed to open output file for writing.");
-            }
-            outf.write(fullText.toUtf8());
-            outf.close();
-            
-            emitProgress("Done", 100);
-            emit finished(outputPath_);
-            
-            // Move back to main thread
-            this->moveToThread(QCoreApplication::instance()->thread());
-            return;
-        }
-
-        // LLM processing
-        emitProgress("Splitting text into batches...", 55);
-        QStringList batches = splitTextIntoBatches(fullText);
-        QStringList llmOut;
-        
-        for (int i = 0; i < batches.size(); ++i) {
-            if (stopFlag_.load()) {
-                throw std::runtime_error("Process stopped by user.");
-            }
-            
-            double progress = 60 + ((i + 1.0) / batches.size()) * 35;
-            emitProgress(QString("Calling LLM (batch %1/%2)").arg(i + 1).arg(batches.size()), progress);
-            
-            QString batchInfo = QString("(Batch %1 of %2)").arg(i + 1).arg(batches.size());
-            QString res = callLLM(batches[i], batchInfo);
-            llmOut << res;
-        }
-
-        QString finalOutput = llmOut.join("\n\n---\n\n");
-        
-        QFile outf(outputPath_);
-        if (!outf.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            throw std::runtime_error("Failed to open output file for writing.");
-        }
-        outf.write(finalOutput.toUtf8());
-        outf.close();
-
-        emitProgress("Done", 100);
-        emit finished(outputPath_);
-        
-    } catch (const std::exception &ex) {
-        emit errorOccurred(QString::fromStdString(ex.what()));
-    } catch (...) {
-        emit errorOccurred("Unknown error during processing.");
-    }
-    
-    // Move back to main thread
-    this->moveToThread(QCoreApplication::instance()->thread());
-}
\ No newline at end of file
@@ -1,31 +1,112 @@
 #pragma once
 #include <QObject>
+#include <QJsonObject>
 #include <QString>
 #include <QStringList>
 #include <QMap>
 #include <QPair>
 #include <QThread>
 #include <atomic>
-#include <QNetworkAccessManager>
-#include <QPdfDocument>
+#include <memory>
+#include "endpoints.h"
+#include "httpclient.h"
+#include "ratelimiter.h"
+#include "textnormalizer.h"
+#include "llmproviders.h"
+#include "pagemodel.h"
+#include "outputformats.h"
+#include "visionengine.h"
+#include <QMutex>
+#include <QPointer>
+
+namespace ocr { class GoogleTokenProvider; class LlmThreads; class MemoryBudget; class OcrEngine; class PageBufferPool; }
 
 class OcrProcessor : public QObject {
     Q_OBJECT
+    // Pages of the current job with their state and text, updated as each one finishes.
+    Q_PROPERTY(PageModel *pages READ pages CONSTANT)
 public:
     explicit OcrProcessor(QObject *parent = nullptr);
     ~OcrProcessor();
 
+    PageModel *pages() const { return pages_; }
+
     Q_INVOKABLE void selectPdf(const QString &path);
     Q_INVOKABLE void selectOutput(const QString &path);
     Q_INVOKABLE void setTesseractPath(const QString &path);
+    // "Tesseract", "Google Vision", or "Tesseract + Vision": Tesseract first, with pages
+    // whose mean word confidence is below the cascade threshold re-read by Vision.
     Q_INVOKABLE void setOcrEngine(const QString &engine);
+    // Tesseract confidence (0-100) a page needs to skip Vision in cascade mode.
+    Q_INVOKABLE void setCascadeThreshold(int confidence);
+    // Tesseract speed/accuracy profile: "draft", "balanced" (default) or "best".
+    // draft and best load tessdata_fast / tessdata_best when installed (see README).
+    Q_INVOKABLE void setOcrProfile(const QString &name);
+    Q_INVOKABLE QStringList ocrProfiles() const;
+    // Tesseract: recognize the text blocks of each page on this many engines at once
+    // (layout is analysed once, text stitched back in reading order). Helps very large
+    // pages such as newspapers; 1 (the default) recognizes the page as a whole.
+    Q_INVOKABLE void setIntraPageThreads(int threads);
+    // Cores a job may use (0 = all), shared between pages in parallel, block threads and
+    // Tesseract's OpenMP threads per engine (OMP_THREAD_LIMIT; fixed once the first
+    // Tesseract job starts, later values are ignored with a warning; 0 keeps the current
+    // limit). pinThreads binds each page worker to its own cores where the OS allows.
+    Q_INVOKABLE void setThreadBudget(int totalThreads, int openMpThreads, bool pinThreads);
+    // Bytes of page data (rendered images, encoded payloads, replies, text waiting to
+    // be written) all jobs may hold at once; pages wait to be rendered while it is spent.
+    // 0 = unlimited. Defaults to OCR_MEMORY_BUDGET_MB or half the physical memory.
+    Q_INVOKABLE void setMemoryBudget(int megabytes);
     Q_INVOKABLE void setLanguage(const QString &langKey);
     Q_INVOKABLE void setApiKey(const QString &key);
     Q_INVOKABLE void setGoogleServiceAccountPath(const QString &path);
     Q_INVOKABLE void setPrompt(const QString &p);
     Q_INVOKABLE void setPageRange(int start, int end);
     Q_INVOKABLE void setOcrOnly(bool ocrOnly);
+    // Instead of the page range, OCR only the pages the existing output file has
+    // failure placeholders for and splice their text into it.
+    Q_INVOKABLE void setRerunFailedPages(bool rerun);
+    // Extra files written beside the output from the same pass: any of "hocr", "tsv",
+    // "alto" and "pdf" (a searchable PDF of the page images). Unknown names are ignored.
+    Q_INVOKABLE void setOutputFormats(const QStringList &formats);
+    Q_INVOKABLE QStringList outputFormats() const;
+    // A provider name ("OpenAI", or one from the provider file) or "Name: model".
     Q_INVOKABLE void setLlmProvider(const QString &provider);
+    // OpenAI-compatible providers (e.g. a local llama.cpp or vLLM server) from a JSON
+    // file, see ocr::loadLlmProviders(); replaces the previously loaded ones. The
+    // default file (OCR_LLM_PROVIDERS_FILE or llm_providers.json in the config
+    // directory) is read at startup. Returns false if the file is unusable.
+    Q_INVOKABLE bool loadLlmProviders(const QString &path);
+    // "Name: model" of the built-in and loaded providers.
+    Q_INVOKABLE QStringList llmProviders() const;
+    // Write a Chrome/Perfetto trace of each job to this path (empty disables tracing).
+    // Defaults to the OCR_TRACE_FILE environment variable.
+    Q_INVOKABLE void setTracePath(const QString &path);
+    // Point a service ("vision", "oauth", "openai", "openrouter") at another base URL,
+    // e.g. the ocr_mock_server from tools/ for offline testing.
+    Q_INVOKABLE void setEndpointBaseUrl(const QString &service, const QString &url);
+    // Upper bound on estimated tokens per LLM request; 0 sizes chunks from the model's limits.
+    Q_INVOKABLE void setChunkTokenBudget(int tokens);
+    // Pages whose local quality score (OCR confidence, dictionary hits, script
+    // consistency, stray symbols; 0-1) reaches minScore are passed through without an
+    // LLM call. 0 (the default) sends everything, as prompts need not be corrections.
+    Q_INVOKABLE void setLlmQualityGate(double minScore);
+    // Bulk mode for jobs that can wait: all LLM batches go to the provider's batch API
+    // as one JSONL file, polled every pollSeconds until done (within 24 hours), at a
+    // lower price. Providers without a batch API are called directly as usual.
+    Q_INVOKABLE void setLlmBulkMode(bool enabled, int pollSeconds = 60);
+    // Local cleanup of text sent to the LLM (on by default): NFC, whitespace and, as
+    // selected, running headers/footers, page numbers and words hyphenated across lines.
+    // The status line reports the estimated tokens saved.
+    Q_INVOKABLE void setTextNormalization(bool enabled, bool stripHeadersFooters,
+                                          bool stripPageNumbers, bool joinHyphenation);
+    // Vision/LLM request resilience: attempts per request (first try included), per-attempt
+    // timeout, delay before a hedged duplicate (0 = no hedging) and retries earned per request.
+    Q_INVOKABLE void setRetryPolicy(int maxAttempts, int timeoutMs, int hedgeAfterMs,
+                                    double retryBudgetRatio);
+    // Caps for a provider ("vision", "OpenAI", "OpenRouter"); 0 leaves a rate unlimited.
+    // Within them the in-flight window adapts to latency and 429 responses.
+    Q_INVOKABLE void setRateLimits(const QString &provider, double requestsPerMinute,
+                                   double tokensPerMinute, int maxConcurrency);
     Q_INVOKABLE void startProcessing();
     Q_INVOKABLE void stopProcessing();
     Q_INVOKABLE QStringList languageOptions() const;
@@ -34,12 +115,11 @@ signals:
     void progressChanged(QString status, double percent);
     void finished(QString outPath);
     void errorOccurred(QString msg);
+    // A page could not be read; the job goes on and writes a placeholder for it.
+    void pageFailed(int page, QString error);
     // Emitted when the background worker/thread has fully stopped and cleaned up
     void stopped();
 
-private slots:
-    void workerRoutine();
-
 private:
     // Configuration
     QString pdfPath_;
@@ -53,30 +133,64 @@ private:
     int startPage_;
     int endPage_;
     bool ocrOnly_;
+    bool rerunFailedPages_ = false;
+    QList<ocr::OutputFormat> outputFormats_;
+    bool normalizeText_ = true;
+    ocr::NormalizationOptions normalization_;
+    int cascadeThreshold_ = 75;
+    QString ocrProfile_ = "balanced";
+    int intraPageThreads_ = 1;
+    int threadBudget_ = 0;
+    bool pinThreads_ = false;
+    QString tracePath_;
+    ocr::Endpoints endpoints_;
+    ocr::RetryPolicy retryPolicy_;
+    mutable QMutex limitersMutex_;
+    QMap<QString, ocr::RateLimits> rateLimits_;
+    QMap<QString, std::shared_ptr<ocr::AdaptiveLimiter>> limiters_;
+    ocr::RateLimits rateLimitsFor(const QString &provider) const;
+    std::shared_ptr<ocr::AdaptiveLimiter> limiterFor(const QString &provider);
     std::atomic<bool> stopFlag_;
+    // Stop flag of the most recently started job; each job gets its own so a queued
+    // job is not cancelled by the stop request aimed at its predecessor.
+    std::shared_ptr<std::atomic<bool>> jobStop_;
+    QPointer<QObject> activeWorker_;
     
     // Threading
     QThread *workerThread_;
-    QNetworkAccessManager *netman_;
 
     // Language mapping
     QMap<QString, QPair<QString, QString>> langMap_;
 
-    // PDF handling
-    QPdfDocument *pdfDoc_;
+    // Page scratch buffers, kept across jobs so long runs stop allocating.
+    std::shared_ptr<ocr::PageBufferPool> pageBuffers_;
+    // Shared by all jobs, like the buffers.
+    std::shared_ptr<ocr::MemoryBudget> memoryBudget_;
+    PageModel *pages_;
 
-    // Helper methods
-    QString renderPageToTempPNG(int pageIndex);
-    QString runTesseractOnImage(const QString &imagePath, const QString &tessLang, const QString &tessdataDir);
-    QString runGoogleVisionOnImage(const QString &imagePath, const QString &visionLang);
     // Google service account auth
-    QString getAccessTokenFromServiceAccount(const QString &jsonPath);
+    std::shared_ptr<ocr::GoogleTokenProvider> tokenProviderFor(const QString &jsonPath);
     QString googleServiceAccountPath_;
-    QString googleAccessToken_;
-    qint64 googleAccessTokenExpiry_ = 0; // unix epoch seconds
-    QString callLLM(const QString &textChunk, const QString &batchInfo);
-    QStringList splitTextIntoBatches(const QString &text, int wordsPerBatch = 1100);
-    QString getTessdataDir();
+    std::shared_ptr<ocr::GoogleTokenProvider> tokenProvider_;
+    // Vision engine shared by the jobs, and the settings it was made with.
+    std::shared_ptr<ocr::OcrEngine> visionEngineFor(const std::shared_ptr<ocr::GoogleTokenProvider> &tokenProvider);
+    std::shared_ptr<ocr::OcrEngine> visionEngine_;
+    ocr::VisionSettings visionSettings_;
+    int visionThreads_ = 0;
+    // Threads the jobs send LLM requests from, likewise kept between jobs.
+    std::shared_ptr<ocr::LlmThreads> llmThreadsFor(const ocr::LlmProvider &provider);
+    std::shared_ptr<ocr::LlmThreads> llmThreads_;
+    QList<ocr::LlmProvider> configuredLlmProviders_;
+    QList<ocr::LlmProvider> allLlmProviders() const;
+    // The selected provider; throws std::runtime_error("Unsupported LLM provider.").
+    ocr::LlmProvider currentLlmProvider() const;
+    QString llmModel() const;
+    int chunkTokenBudget() const;
+    int chunkTokenBudget_ = 0;
+    double llmQualityGate_ = 0;
+    bool llmBulk_ = false;
+    int llmBulkPollSeconds_ = 60;
+    void flushTrace();
 
     void emitProgress(const QString &s, double p) { 
         emit progressChanged(s, p); 
@@ -0,0 +1,35 @@
+#include "ocrprofile.h"
+#include <tesseract/publictypes.h>
+
+namespace ocr {
+
+QStringList ocrProfileNames() {
+    return {"draft", "balanced", "best"};
+}
+
+OcrProfile ocrProfile(const QString &name) {
+    OcrProfile profile;
+    profile.engineMode = tesseract::OEM_DEFAULT;
+    profile.pageSegMode = tesseract::PSM_AUTO;
+
+    if (name == "draft") {
+        profile.name = name;
+        profile.modelSet = "fast";
+        profile.engineMode = tesseract::OEM_LSTM_ONLY;
+        profile.initVariables = {{"load_system_dawg", "0"}, {"load_freq_dawg", "0"}};
+        profile.variables = {{"tessedit_do_invert", "0"}};
+    } else if (name == "best") {
+        profile.name = name;
+        profile.modelSet = "best";
+        profile.engineMode = tesseract::OEM_LSTM_ONLY;
+        // No dictionary/penalty tuning: language_model_penalty_*, segment_penalty_* and
+        // friends only steer the legacy engine's word search, which the tessdata_best
+        // models do not contain. The LSTM decoder applies the (default-loaded) word
+        // lists itself with fixed weights, so the models are the whole difference.
+    } else {
+        profile.name = "balanced";
+    }
+    return profile;
+}
+
+} // namespace ocr
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+namespace ocr {
+
+// A named speed/accuracy trade-off for Tesseract.
+struct OcrProfile {
+    QString name;
+    QString modelSet;      // "fast", "best", or empty for the models in tessdata itself
+    int engineMode = 3;    // tesseract::OcrEngineMode (3 = OEM_DEFAULT)
+    int pageSegMode = 3;   // tesseract::PageSegMode (3 = PSM_AUTO)
+    // Only honoured at Init(), e.g. the dictionary switches.
+    QList<QPair<QByteArray, QByteArray>> initVariables;
+    QList<QPair<QByteArray, QByteArray>> variables;
+};
+
+// "draft": tessdata_fast, LSTM only, no dictionaries, no inverted-text pass; for triage.
+// "balanced": Tesseract's defaults with whatever models tessdata holds (the old behaviour).
+// "best": tessdata_best, LSTM only, dictionaries on; for final runs.
+QStringList ocrProfileNames();
+// Unknown names give "balanced".
+OcrProfile ocrProfile(const QString &name);
+
+} // namespace ocr
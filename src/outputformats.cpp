@@ -0,0 +1,352 @@
+#include "outputformats.h"
+#include "searchablepdf.h"
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QPainter>
+#include <climits>
+#include <stdexcept>
+
+namespace ocr {
+
+QStringList outputFormatNames() {
+    return {"hocr", "tsv", "alto", "pdf"};
+}
+
+QString outputFormatName(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::Hocr: return "hocr";
+    case OutputFormat::Tsv: return "tsv";
+    case OutputFormat::Alto: return "alto";
+    case OutputFormat::Pdf: return "pdf";
+    }
+    return QString();
+}
+
+QList<OutputFormat> parseOutputFormats(const QStringList &names) {
+    QList<OutputFormat> formats;
+    for (const QString &name : names) {
+        const int index = outputFormatNames().indexOf(name.trimmed().toLower());
+        if (index < 0) continue;
+        const OutputFormat format = static_cast<OutputFormat>(index);
+        if (!formats.contains(format)) formats << format;
+    }
+    return formats;
+}
+
+QString outputFormatPath(const QString &textOutput, OutputFormat format) {
+    const QFileInfo info(textOutput);
+    const QString base = info.path() + QLatin1Char('/') + info.completeBaseName();
+    switch (format) {
+    case OutputFormat::Hocr: return base + ".hocr";
+    case OutputFormat::Tsv: return base + ".tsv";
+    case OutputFormat::Alto: return base + ".xml";
+    case OutputFormat::Pdf: return base + ".pdf";
+    }
+    return base;
+}
+
+// Vision boxes are polygons of (x, y) vertices; zero coordinates are left out.
+static QRect visionBox(const QJsonObject &boundingBox) {
+    const QJsonArray vertices = boundingBox.value("vertices").toArray();
+    if (vertices.isEmpty()) return QRect();
+    int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+    for (const QJsonValue &v : vertices) {
+        const int x = v.toObject().value("x").toInt();
+        const int y = v.toObject().value("y").toInt();
+        left = qMin(left, x);
+        top = qMin(top, y);
+        right = qMax(right, x);
+        bottom = qMax(bottom, y);
+    }
+    return QRect(left, top, right - left, bottom - top);
+}
+
+PageLayout layoutFromVision(const QJsonObject &fullTextAnnotation) {
+    PageLayout layout;
+    const QJsonArray pages = fullTextAnnotation.value("pages").toArray();
+    if (pages.isEmpty()) return layout;
+    const QJsonObject page = pages.first().toObject();
+    layout.size = QSize(page.value("width").toInt(), page.value("height").toInt());
+    for (const QJsonValue &blockValue : page.value("blocks").toArray()) {
+        const QJsonObject block = blockValue.toObject();
+        LayoutBlock outBlock;
+        outBlock.box = visionBox(block.value("boundingBox").toObject());
+        for (const QJsonValue &paragraphValue : block.value("paragraphs").toArray()) {
+            const QJsonObject paragraph = paragraphValue.toObject();
+            LayoutParagraph outParagraph;
+            outParagraph.box = visionBox(paragraph.value("boundingBox").toObject());
+            LayoutLine line;
+            for (const QJsonValue &wordValue : paragraph.value("words").toArray()) {
+                const QJsonObject word = wordValue.toObject();
+                LayoutWord outWord;
+                outWord.box = visionBox(word.value("boundingBox").toObject());
+                if (word.contains("confidence")) {
+                    outWord.confidence = qRound(word.value("confidence").toDouble() * 100);
+                }
+                QString breakType;
+                for (const QJsonValue &symbol : word.value("symbols").toArray()) {
+                    outWord.text += symbol.toObject().value("text").toString();
+                    breakType = symbol.toObject()
+                                    .value("property").toObject()
+                                    .value("detectedBreak").toObject()
+                                    .value("type").toString();
+                }
+                line.words << outWord;
+                line.box = line.box.united(outWord.box);
+                if (breakType == "EOL_SURE_SPACE" || breakType == "LINE_BREAK" || breakType == "HYPHEN") {
+                    outParagraph.lines << line;
+                    line = LayoutLine();
+                }
+            }
+            if (!line.words.isEmpty()) outParagraph.lines << line;
+            outBlock.paragraphs << outParagraph;
+        }
+        layout.blocks << outBlock;
+    }
+    return layout;
+}
+
+// "l t r b" as hOCR writes a box, right and bottom exclusive.
+static QString hocrBox(const QRect &box) {
+    return QString("bbox %1 %2 %3 %4").arg(box.x()).arg(box.y()).arg(box.x() + box.width()).arg(box.y() + box.height());
+}
+
+static QString altoBox(const QRect &box) {
+    return QString("HPOS=\"%1\" VPOS=\"%2\" WIDTH=\"%3\" HEIGHT=\"%4\"")
+        .arg(box.x()).arg(box.y()).arg(box.width()).arg(box.height());
+}
+
+static QString tsvRow(int level, int page, int block, int paragraph, int line, int word, const QRect &box,
+                      int confidence, const QString &text) {
+    QString clean = text;
+    clean.replace(QLatin1Char('\t'), QLatin1Char(' ')).replace(QLatin1Char('\n'), QLatin1Char(' '));
+    return QString("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\t%9\t%10\t%11\t%12\n")
+        .arg(level).arg(page).arg(block).arg(paragraph).arg(line).arg(word)
+        .arg(box.x()).arg(box.y()).arg(box.width()).arg(box.height())
+        .arg(confidence).arg(clean);
+}
+
+static QByteArray hocrPage(const PageLayout &layout, int pageNumber, int dpi) {
+    QString out = QString("  <div class='ocr_page' id='page_%1' title='image \"\"; %2; ppageno %3; scan_res %4 %4'>\n")
+                      .arg(pageNumber).arg(hocrBox(QRect(QPoint(0, 0), layout.size))).arg(pageNumber - 1).arg(dpi);
+    int blockId = 0, paragraphId = 0, lineId = 0, wordId = 0;
+    for (const LayoutBlock &block : layout.blocks) {
+        out += QString("   <div class='ocr_carea' id='block_%1_%2' title=\"%3\">\n")
+                   .arg(pageNumber).arg(++blockId).arg(hocrBox(block.box));
+        for (const LayoutParagraph &paragraph : block.paragraphs) {
+            out += QString("    <p class='ocr_par' id='par_%1_%2' title=\"%3\">\n")
+                       .arg(pageNumber).arg(++paragraphId).arg(hocrBox(paragraph.box));
+            for (const LayoutLine &line : paragraph.lines) {
+                out += QString("     <span class='ocr_line' id='line_%1_%2' title=\"%3\">")
+                           .arg(pageNumber).arg(++lineId).arg(hocrBox(line.box));
+                for (const LayoutWord &word : line.words) {
+                    QString title = hocrBox(word.box);
+                    if (word.confidence >= 0) title += QString("; x_wconf %1").arg(word.confidence);
+                    out += QString("\n      <span class='ocrx_word' id='word_%1_%2' title='%3'>%4</span>")
+                               .arg(pageNumber).arg(++wordId).arg(title, word.text.toHtmlEscaped());
+                }
+                out += "\n     </span>\n";
+            }
+            out += "    </p>\n";
+        }
+        out += "   </div>\n";
+    }
+    out += "  </div>\n";
+    return out.toUtf8();
+}
+
+static QByteArray tsvPage(const PageLayout &layout, int pageNumber) {
+    QString out = tsvRow(1, pageNumber, 0, 0, 0, 0, QRect(QPoint(0, 0), layout.size), -1, QString());
+    int blockId = 0;
+    for (const LayoutBlock &block : layout.blocks) {
+        out += tsvRow(2, pageNumber, ++blockId, 0, 0, 0, block.box, -1, QString());
+        int paragraphId = 0;
+        for (const LayoutParagraph &paragraph : block.paragraphs) {
+            out += tsvRow(3, pageNumber, blockId, ++paragraphId, 0, 0, paragraph.box, -1, QString());
+            int lineId = 0;
+            for (const LayoutLine &line : paragraph.lines) {
+                out += tsvRow(4, pageNumber, blockId, paragraphId, ++lineId, 0, line.box, -1, QString());
+                int wordId = 0;
+                for (const LayoutWord &word : line.words) {
+                    out += tsvRow(5, pageNumber, blockId, paragraphId, lineId, ++wordId, word.box,
+                                  word.confidence, word.text);
+                }
+            }
+        }
+    }
+    return out.toUtf8();
+}
+
+static QByteArray altoPage(const PageLayout &layout, int pageNumber) {
+    const QRect page(QPoint(0, 0), layout.size);
+    QString out = QString("\t\t<Page WIDTH=\"%1\" HEIGHT=\"%2\" PHYSICAL_IMG_NR=\"%3\" ID=\"page_%3\">\n"
+                          "\t\t\t<PrintSpace %4>\n")
+                      .arg(layout.size.width()).arg(layout.size.height()).arg(pageNumber - 1).arg(altoBox(page));
+    int blockId = 0, paragraphId = 0, lineId = 0, wordId = 0;
+    for (const LayoutBlock &block : layout.blocks) {
+        out += QString("\t\t\t\t<ComposedBlock ID=\"cblock_%1_%2\" %3>\n")
+                   .arg(pageNumber).arg(++blockId).arg(altoBox(block.box));
+        for (const LayoutParagraph &paragraph : block.paragraphs) {
+            out += QString("\t\t\t\t\t<TextBlock ID=\"block_%1_%2\" %3>\n")
+                       .arg(pageNumber).arg(++paragraphId).arg(altoBox(paragraph.box));
+            for (const LayoutLine &line : paragraph.lines) {
+                out += QString("\t\t\t\t\t\t<TextLine ID=\"line_%1_%2\" %3>\n")
+                           .arg(pageNumber).arg(++lineId).arg(altoBox(line.box));
+                for (const LayoutWord &word : line.words) {
+                    QString confidence;
+                    if (word.confidence >= 0) {
+                        confidence = QString(" WC=\"%1\"").arg(word.confidence / 100.0, 0, 'f', 2);
+                    }
+                    out += QString("\t\t\t\t\t\t\t<String ID=\"string_%1_%2\" %3%4 CONTENT=\"%5\"/>\n")
+                               .arg(pageNumber).arg(++wordId).arg(altoBox(word.box), confidence,
+                                                                  word.text.toHtmlEscaped());
+                }
+                out += "\t\t\t\t\t\t</TextLine>\n";
+            }
+            out += "\t\t\t\t\t</TextBlock>\n";
+        }
+        out += "\t\t\t\t</ComposedBlock>\n";
+    }
+    out += "\t\t\t</PrintSpace>\n\t\t</Page>\n";
+    return out.toUtf8();
+}
+
+QByteArray renderPageFragment(OutputFormat format, const PageLayout &layout, int pageNumber, int dpi) {
+    switch (format) {
+    case OutputFormat::Hocr: return hocrPage(layout, pageNumber, dpi);
+    case OutputFormat::Tsv: return tsvPage(layout, pageNumber);
+    case OutputFormat::Alto: return altoPage(layout, pageNumber);
+    case OutputFormat::Pdf: break;
+    }
+    return QByteArray();
+}
+
+qint64 PageRendering::bytes() const {
+    qint64 total = jpeg.size();
+    for (const QByteArray &fragment : fragments) total += fragment.size();
+    for (const LayoutBlock &block : layout.blocks) {
+        for (const LayoutParagraph &paragraph : block.paragraphs) {
+            for (const LayoutLine &line : paragraph.lines) total += line.words.size() * qint64(sizeof(LayoutWord) + 16);
+        }
+    }
+    return total;
+}
+
+QByteArray pageImageJpeg(const QImage &image, bool *grayscale) {
+    // Rendered pages have a transparent background; PDF images have none.
+    QImage flat(image.size(), QImage::Format_RGB32);
+    flat.fill(Qt::white);
+    {
+        QPainter painter(&flat);
+        painter.drawImage(0, 0, image);
+    }
+    *grayscale = flat.allGray();
+    if (*grayscale) flat = flat.convertToFormat(QImage::Format_Grayscale8);
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    if (!flat.save(&buffer, "JPG", 85)) throw std::runtime_error("Failed to compress page image for the PDF.");
+    return jpeg;
+}
+
+static QByteArray documentHeader(OutputFormat format, const QString &title) {
+    switch (format) {
+    case OutputFormat::Hocr:
+        return QString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Transitional//EN\"\n"
+                       "    \"http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd\">\n"
+                       "<html xmlns=\"http://www.w3.org/1999/xhtml\" xml:lang=\"en\" lang=\"en\">\n"
+                       " <head>\n"
+                       "  <title>%1</title>\n"
+                       "  <meta http-equiv=\"Content-Type\" content=\"text/html;charset=utf-8\"/>\n"
+                       "  <meta name='ocr-system' content='OCRLLMProcessor' />\n"
+                       "  <meta name='ocr-capabilities' content='ocr_page ocr_carea ocr_par ocr_line ocrx_word ocrp_wconf'/>\n"
+                       " </head>\n"
+                       " <body>\n")
+            .arg(title.toHtmlEscaped())
+            .toUtf8();
+    case OutputFormat::Tsv:
+        return "level\tpage_num\tblock_num\tpar_num\tline_num\tword_num\tleft\ttop\twidth\theight\tconf\ttext\n";
+    case OutputFormat::Alto:
+        return QString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<alto xmlns=\"http://www.loc.gov/standards/alto/ns-v3#\" "
+                       "xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+                       "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+                       "xsi:schemaLocation=\"http://www.loc.gov/standards/alto/ns-v3# "
+                       "http://www.loc.gov/alto/v3/alto-3-0.xsd\">\n"
+                       "\t<Description>\n"
+                       "\t\t<MeasurementUnit>pixel</MeasurementUnit>\n"
+                       "\t\t<sourceImageInformation>\n"
+                       "\t\t\t<fileName>%1</fileName>\n"
+                       "\t\t</sourceImageInformation>\n"
+                       "\t\t<OCRProcessing ID=\"OCR_0\">\n"
+                       "\t\t\t<ocrProcessingStep>\n"
+                       "\t\t\t\t<processingSoftware>\n"
+                       "\t\t\t\t\t<softwareName>OCRLLMProcessor</softwareName>\n"
+                       "\t\t\t\t</processingSoftware>\n"
+                       "\t\t\t</ocrProcessingStep>\n"
+                       "\t\t</OCRProcessing>\n"
+                       "\t</Description>\n"
+                       "\t<Layout>\n")
+            .arg(title.toHtmlEscaped())
+            .toUtf8();
+    case OutputFormat::Pdf:
+        break;
+    }
+    return QByteArray();
+}
+
+static QByteArray documentFooter(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::Hocr: return " </body>\n</html>\n";
+    case OutputFormat::Alto: return "\t</Layout>\n</alto>\n";
+    case OutputFormat::Tsv:
+    case OutputFormat::Pdf: break;
+    }
+    return QByteArray();
+}
+
+OutputWriter::OutputWriter(OutputFormat format, const QString &path, const QString &title,
+                           const QString &fontFile)
+    : format_(format), file_(path) {
+    if (!file_.open(QIODevice::WriteOnly)) {
+        throw std::runtime_error(QString("Failed to open %1 for writing.").arg(path).toStdString());
+    }
+    if (format_ == OutputFormat::Pdf) {
+        QByteArray font;
+        QFile f(fontFile);
+        if (!fontFile.isEmpty() && f.open(QIODevice::ReadOnly)) font = f.readAll();
+        pdf_ = std::make_unique<SearchablePdfWriter>([this](const QByteArray &bytes) { write(bytes); }, font);
+    } else {
+        write(documentHeader(format_, title));
+    }
+}
+
+OutputWriter::~OutputWriter() = default;
+
+void OutputWriter::addPage(const PageRendering &page) {
+    if (pdf_) {
+        if (!page.jpeg.isEmpty()) pdf_->addPage(page.layout, page.jpeg, page.imageSize, page.grayscale, page.dpi);
+    } else {
+        write(page.fragments.value(format_));
+    }
+}
+
+void OutputWriter::commit() {
+    if (pdf_) pdf_->finish();
+    else write(documentFooter(format_));
+    if (!file_.commit()) {
+        throw std::runtime_error(QString("Failed to write %1.").arg(file_.fileName()).toStdString());
+    }
+}
+
+void OutputWriter::write(const QByteArray &bytes) {
+    if (file_.write(bytes) != bytes.size()) {
+        throw std::runtime_error(QString("Failed to write %1.").arg(file_.fileName()).toStdString());
+    }
+}
+
+} // namespace ocr
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QRect>
+#include <QSaveFile>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+class QImage;
+
+namespace ocr {
+
+class SearchablePdfWriter;
+
+// Files written next to the text output from the same recognition pass.
+enum class OutputFormat { Hocr, Tsv, Alto, Pdf };
+
+// "hocr", "tsv", "alto", "pdf".
+QStringList outputFormatNames();
+QString outputFormatName(OutputFormat format);
+// Unknown names are skipped; duplicates collapse.
+QList<OutputFormat> parseOutputFormats(const QStringList &names);
+// textOutput with its suffix replaced the way Tesseract names its outputs:
+// .hocr, .tsv, .xml (ALTO), .pdf.
+QString outputFormatPath(const QString &textOutput, OutputFormat format);
+
+// Words of a page with their boxes in image pixels, grouped the way Tesseract's
+// iterators (and Vision's blocks/paragraphs) group them.
+struct LayoutWord {
+    QRect box;
+    QString text;
+    int confidence = -1; // 0-100, -1 if unknown
+};
+struct LayoutLine {
+    QRect box;
+    QList<LayoutWord> words;
+};
+struct LayoutParagraph {
+    QRect box;
+    QList<LayoutLine> lines;
+};
+struct LayoutBlock {
+    QRect box;
+    QList<LayoutParagraph> paragraphs;
+};
+struct PageLayout {
+    QSize size;
+    QList<LayoutBlock> blocks;
+};
+
+// The first page of Vision's fullTextAnnotation. Vision has no lines; a line ends at
+// a word whose last symbol carries a line break (EOL_SURE_SPACE, LINE_BREAK, HYPHEN).
+PageLayout layoutFromVision(const QJsonObject &fullTextAnnotation);
+
+// One page in format (not Pdf), as Tesseract's renderers lay it out: an ocr_page
+// div, the TSV rows of the page, or an ALTO <Page>. pageNumber is 1-based.
+QByteArray renderPageFragment(OutputFormat format, const PageLayout &layout, int pageNumber, int dpi);
+
+// Extra formats wanted from a recognition besides the text.
+struct RenderRequest {
+    QList<OutputFormat> formats;
+    int pageNumber = 1; // 1-based, for page ids
+    int dpi = 300;
+};
+
+// What the extra formats need of one recognized page.
+struct PageRendering {
+    int pageNumber = 0;
+    int dpi = 300;
+    QSize imageSize;
+    PageLayout layout;                       // for the searchable PDF
+    QMap<OutputFormat, QByteArray> fragments; // text formats, from the engine
+    QByteArray jpeg;                          // page image for the searchable PDF
+    bool grayscale = false;
+
+    qint64 bytes() const;
+};
+
+// The rendered page compressed for the searchable PDF; gray pages stay one channel.
+QByteArray pageImageJpeg(const QImage &image, bool *grayscale);
+
+// One extra output file, streamed in page order: the document header when opened,
+// each page as it is added, the footer on commit(). Written to a temporary file that
+// replaces path only on commit(), like the text output.
+class OutputWriter {
+public:
+    // fontFile: glyph-less font (Tesseract's pdf.ttf) embedded in the searchable PDF,
+    // if it exists. Throws std::runtime_error if path cannot be opened.
+    OutputWriter(OutputFormat format, const QString &path, const QString &title,
+                 const QString &fontFile = QString());
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter &operator=(const OutputWriter &) = delete;
+
+    OutputFormat format() const { return format_; }
+    QString path() const { return file_.fileName(); }
+
+    void addPage(const PageRendering &page);
+    void commit();
+
+private:
+    void write(const QByteArray &bytes);
+
+    OutputFormat format_;
+    QSaveFile file_;
+    std::unique_ptr<SearchablePdfWriter> pdf_;
+};
+
+} // namespace ocr
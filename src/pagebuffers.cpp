@@ -0,0 +1,79 @@
+#include "pagebuffers.h"
+#include <QBuffer>
+#include <QImage>
+#include <QMutexLocker>
+#include <leptonica/allheaders.h>
+
+namespace ocr {
+
+PageBuffer::~PageBuffer() {
+    if (pix_) pixDestroy(&pix_);
+}
+
+Pix *PageBuffer::grayPix(const QImage &image, int dpi) {
+    const int w = image.width();
+    const int h = image.height();
+    if (!pix_ || pixGetWidth(pix_) != w || pixGetHeight(pix_) != h) {
+        if (pix_) pixDestroy(&pix_);
+        pix_ = pixCreateNoInit(w, h, 8);
+        ++reallocations_;
+    }
+    if (!pix_) return nullptr;
+    pixSetResolution(pix_, dpi, dpi);
+
+    // Rendered pages are (A)RGB32; anything else is converted once up front.
+    const QImage src = (image.format() == QImage::Format_ARGB32_Premultiplied ||
+                        image.format() == QImage::Format_ARGB32 ||
+                        image.format() == QImage::Format_RGB32)
+                           ? image
+                           : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const bool premultiplied = src.format() != QImage::Format_ARGB32;
+    l_uint32 *data = pixGetData(pix_);
+    const int wpl = pixGetWpl(pix_);
+    for (int y = 0; y < h; ++y) {
+        const QRgb *in = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+        l_uint32 *line = data + y * wpl;
+        for (int x = 0; x < w; ++x) {
+            const QRgb p = in[x];
+            const int a = qAlpha(p);
+            int gray = qGray(p);
+            // Composite on white: transparent areas of a page are paper, not ink.
+            gray = premultiplied ? gray + (255 - a) : (gray * a + 255 * (255 - a)) / 255;
+            SET_DATA_BYTE(line, x, qMin(gray, 255));
+        }
+    }
+    return pix_;
+}
+
+const QByteArray &PageBuffer::png(const QImage &image) {
+    const qsizetype capacity = encoded_.capacity();
+    QBuffer out(&encoded_);
+    out.open(QIODevice::WriteOnly); // truncates but keeps the allocation
+    image.save(&out, "PNG");
+    out.close();
+    if (encoded_.capacity() > capacity) ++reallocations_;
+    return encoded_;
+}
+
+PageBufferPool::Lease PageBufferPool::acquire() {
+    QMutexLocker lock(&mutex_);
+    if (!idle_.empty()) {
+        std::unique_ptr<PageBuffer> buffer = std::move(idle_.back());
+        idle_.pop_back();
+        return Lease(this, std::move(buffer));
+    }
+    ++created_;
+    return Lease(this, std::make_unique<PageBuffer>());
+}
+
+int PageBufferPool::created() const {
+    QMutexLocker lock(&mutex_);
+    return created_;
+}
+
+void PageBufferPool::release(std::unique_ptr<PageBuffer> buffer) {
+    QMutexLocker lock(&mutex_);
+    if (static_cast<int>(idle_.size()) < maxIdle_) idle_.push_back(std::move(buffer));
+}
+
+} // namespace ocr
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <memory>
+#include <vector>
+
+class QImage;
+struct Pix;
+
+namespace ocr {
+
+// Scratch memory for one page on its way through OCR. Buffers keep their capacity
+// between pages, so once a job has warmed up a page of the same size needs no new
+// multi-megabyte allocations beyond the rendered QImage itself.
+class PageBuffer {
+public:
+    PageBuffer() = default;
+    ~PageBuffer();
+    PageBuffer(const PageBuffer &) = delete;
+    PageBuffer &operator=(const PageBuffer &) = delete;
+
+    // 8 bpp grayscale copy of image (composited on white) for Tesseract, which
+    // binarizes grayscale anyway. The Pix stays owned by the buffer.
+    Pix *grayPix(const QImage &image, int dpi);
+    // image as PNG, e.g. for Vision. Valid until the next call.
+    const QByteArray &png(const QImage &image);
+
+    int reallocations() const { return reallocations_; }
+
+private:
+    Pix *pix_ = nullptr;
+    QByteArray encoded_;
+    int reallocations_ = 0;
+};
+
+// Free list of PageBuffers shared by all page workers (and jobs). acquire() hands
+// out an idle buffer or makes a new one; the lease gives it back when destroyed.
+class PageBufferPool {
+public:
+    class Lease {
+    public:
+        Lease(PageBufferPool *pool, std::unique_ptr<PageBuffer> buffer)
+            : pool_(pool), buffer_(std::move(buffer)) {}
+        Lease(Lease &&) = default;
+        ~Lease() { if (buffer_) pool_->release(std::move(buffer_)); }
+
+        PageBuffer *operator->() const { return buffer_.get(); }
+        PageBuffer &operator*() const { return *buffer_; }
+
+    private:
+        PageBufferPool *pool_;
+        std::unique_ptr<PageBuffer> buffer_;
+    };
+
+    // maxIdle bounds the memory kept once the workers are done with it.
+    explicit PageBufferPool(int maxIdle = 8) : maxIdle_(maxIdle) {}
+
+    Lease acquire();
+    int created() const;
+
+private:
+    void release(std::unique_ptr<PageBuffer> buffer);
+
+    mutable QMutex mutex_;
+    std::vector<std::unique_ptr<PageBuffer>> idle_;
+    int maxIdle_;
+    int created_ = 0;
+};
+
+} // namespace ocr
@@ -0,0 +1,45 @@
+#include "pagefailures.h"
+#include <QRegularExpression>
+
+namespace ocr {
+
+static const QRegularExpression &placeholderPattern() {
+    static const QRegularExpression pattern("^\\[OCR failed on page (\\d+): (.*)\\]$",
+                                            QRegularExpression::MultilineOption);
+    return pattern;
+}
+
+QString failurePlaceholder(int page, const QString &error) {
+    QString detail = error.simplified();
+    if (detail.isEmpty()) detail = "unknown error";
+    return QString("[OCR failed on page %1: %2]").arg(page).arg(detail);
+}
+
+QList<PageFailure> findFailedPages(const QString &output) {
+    QList<PageFailure> failures;
+    auto it = placeholderPattern().globalMatch(output);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch m = it.next();
+        failures.append({m.captured(1).toInt(), m.captured(2)});
+    }
+    return failures;
+}
+
+QString spliceRecoveredPages(const QString &output, const QMap<int, QString> &recovered) {
+    QString result;
+    result.reserve(output.size());
+    qsizetype copied = 0;
+    auto it = placeholderPattern().globalMatch(output);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch m = it.next();
+        const int page = m.captured(1).toInt();
+        if (!recovered.contains(page)) continue;
+        result += QStringView(output).mid(copied, m.capturedStart() - copied);
+        result += recovered.value(page);
+        copied = m.capturedEnd();
+    }
+    result += QStringView(output).mid(copied);
+    return result;
+}
+
+} // namespace ocr
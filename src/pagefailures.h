@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QString>
+
+namespace ocr {
+
+struct PageFailure {
+    int page = 0; // 1-based
+    QString error;
+};
+
+// Line written to the output in place of a page that could not be read, e.g.
+// "[OCR failed on page 12: Failed to render PDF page]". The error is kept on one line.
+QString failurePlaceholder(int page, const QString &error);
+
+// Placeholders in a previously written output, in the order they appear.
+QList<PageFailure> findFailedPages(const QString &output);
+
+// output with the placeholder of each page in recovered replaced by its text;
+// placeholders of other pages are left as they are.
+QString spliceRecoveredPages(const QString &output, const QMap<int, QString> &recovered);
+
+} // namespace ocr
@@ -0,0 +1,109 @@
+#include "pagemodel.h"
+
+static QString stateName(PageModel::State state) {
+    switch (state) {
+    case PageModel::Pending: return "pending";
+    case PageModel::Rendering: return "rendering";
+    case PageModel::Recognizing: return "ocr";
+    case PageModel::Done: return "done";
+    case PageModel::Failed: return "failed";
+    }
+    return QString();
+}
+
+PageModel::PageModel(QObject *parent) : QAbstractListModel(parent) {}
+
+int PageModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : pages_.size();
+}
+
+QVariant PageModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= pages_.size()) return QVariant();
+    const Page &page = pages_[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+    case PageNumberRole: return page.number;
+    case StateRole: return int(page.state);
+    case StateNameRole: return stateName(page.state);
+    case TextRole: return page.text;
+    case ConfidenceRole: return page.confidence;
+    case RenderMsRole: return page.renderMs;
+    case OcrMsRole: return page.ocrMs;
+    case ErrorRole: return page.error;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> PageModel::roleNames() const {
+    return {
+        {PageNumberRole, "pageNumber"},
+        {StateRole, "state"},
+        {StateNameRole, "stateName"},
+        {TextRole, "text"},
+        {ConfidenceRole, "confidence"},
+        {RenderMsRole, "renderMs"},
+        {OcrMsRole, "ocrMs"},
+        {ErrorRole, "error"},
+    };
+}
+
+QString PageModel::text(int row) const {
+    return row >= 0 && row < pages_.size() ? pages_[row].text : QString();
+}
+
+void PageModel::reset(const QList<int> &pages) {
+    beginResetModel();
+    pages_.clear();
+    rowOfPage_.clear();
+    for (int number : pages) {
+        rowOfPage_.insert(number, pages_.size());
+        Page page;
+        page.number = number;
+        pages_.append(page);
+    }
+    finished_ = 0;
+    endResetModel();
+    emit countChanged();
+    emit finishedCountChanged();
+}
+
+void PageModel::update(int page, const std::function<void(Page &)> &change, const QList<int> &roles) {
+    const int row = rowOfPage_.value(page, -1);
+    if (row < 0) return;
+    Page &entry = pages_[row];
+    const bool wasFinished = entry.state == Done || entry.state == Failed;
+    change(entry);
+    const bool isFinished = entry.state == Done || entry.state == Failed;
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, roles);
+    if (wasFinished != isFinished) {
+        finished_ += isFinished ? 1 : -1;
+        emit finishedCountChanged();
+    }
+}
+
+void PageModel::setState(int page, int state) {
+    update(page, [state](Page &p) { p.state = State(state); }, {StateRole, StateNameRole});
+}
+
+void PageModel::setResult(int page, const QString &text, int confidence, qint64 renderMs, qint64 ocrMs) {
+    update(page,
+           [&](Page &p) {
+               p.state = Done;
+               p.text = text;
+               p.confidence = confidence;
+               p.renderMs = renderMs;
+               p.ocrMs = ocrMs;
+               p.error.clear();
+           },
+           {StateRole, StateNameRole, TextRole, ConfidenceRole, RenderMsRole, OcrMsRole, ErrorRole});
+}
+
+void PageModel::setFailed(int page, const QString &error) {
+    update(page,
+           [&](Page &p) {
+               p.state = Failed;
+               p.error = error;
+           },
+           {StateRole, StateNameRole, ErrorRole});
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <functional>
+
+// Per-page progress and results of the current job, for QML. Rows are added when the
+// job's pages are known and updated as each page moves through the pipeline, so the
+// first page's text can be checked while the rest are still being read.
+class PageModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(int finishedCount READ finishedCount NOTIFY finishedCountChanged)
+
+public:
+    enum State { Pending, Rendering, Recognizing, Done, Failed };
+    Q_ENUM(State)
+
+    enum Roles {
+        PageNumberRole = Qt::UserRole + 1,
+        StateRole,      // State
+        StateNameRole,  // "pending", "rendering", "ocr", "done", "failed"
+        TextRole,
+        ConfidenceRole, // mean Tesseract word confidence 0-100, -1 if unknown
+        RenderMsRole,
+        OcrMsRole,
+        ErrorRole,
+    };
+
+    explicit PageModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Pages done or failed.
+    int finishedCount() const { return finished_; }
+
+    Q_INVOKABLE QString text(int row) const;
+
+public slots:
+    // Starts over with these (1-based) pages, all pending.
+    void reset(const QList<int> &pages);
+    void setState(int page, int state);
+    void setResult(int page, const QString &text, int confidence, qint64 renderMs, qint64 ocrMs);
+    void setFailed(int page, const QString &error);
+
+signals:
+    void countChanged();
+    void finishedCountChanged();
+
+private:
+    struct Page {
+        int number = 0;
+        State state = Pending;
+        QString text;
+        int confidence = -1;
+        qint64 renderMs = -1;
+        qint64 ocrMs = -1;
+        QString error;
+    };
+
+    void update(int page, const std::function<void(Page &)> &change, const QList<int> &roles);
+
+    QList<Page> pages_;
+    QHash<int, int> rowOfPage_;
+    int finished_ = 0;
+};
@@ -0,0 +1,170 @@
+#include "ratelimiter.h"
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace ocr {
+
+void AdaptiveLimiter::Bucket::configure(double perMinute, qint64 now) {
+    if (perMinute <= 0) {
+        capacity = 0;
+        return;
+    }
+    // Allow bursts of ten seconds' worth so a fresh job does not start at full speed
+    // into an already partly used quota.
+    capacity = std::max(1.0, perMinute / 6.0);
+    perMs = perMinute / 60000.0;
+    level = std::min(level, capacity);
+    if (last == 0) level = capacity;
+    last = now;
+}
+
+void AdaptiveLimiter::Bucket::refill(qint64 now) {
+    if (capacity <= 0) return;
+    level = std::min(capacity, level + (now - last) * perMs);
+    last = now;
+}
+
+qint64 AdaptiveLimiter::Bucket::waitFor(double n) const {
+    if (capacity <= 0) return 0;
+    n = std::min(n, capacity);
+    if (level >= n) return 0;
+    return static_cast<qint64>(std::ceil((n - level) / perMs));
+}
+
+void AdaptiveLimiter::Bucket::take(double n) {
+    if (capacity <= 0) return;
+    level -= std::min(n, capacity);
+}
+
+AdaptiveLimiter::AdaptiveLimiter(const RateLimits &limits)
+    : window_(limits.initialConcurrency), inFlight_(0), pausedUntil_(0), baselineLatencyMs_(0) {
+    clock_.start();
+    setLimits(limits);
+    window_ = std::clamp<double>(limits_.initialConcurrency, limits_.minConcurrency,
+                                 limits_.maxConcurrency);
+}
+
+void AdaptiveLimiter::setLimits(const RateLimits &limits) {
+    QMutexLocker lock(&mutex_);
+    limits_ = limits;
+    limits_.minConcurrency = std::max(1, limits_.minConcurrency);
+    limits_.maxConcurrency = std::max(limits_.minConcurrency, limits_.maxConcurrency);
+    const qint64 now = clock_.elapsed() + 1; // keep last != 0 once configured
+    requests_.configure(limits_.requestsPerMinute, now);
+    tokens_.configure(limits_.tokensPerMinute, now);
+    window_ = std::clamp<double>(window_, limits_.minConcurrency, limits_.maxConcurrency);
+}
+
+bool AdaptiveLimiter::tryTakeLocked(double tokens, qint64 *waitMs) {
+    const qint64 now = clock_.elapsed() + 1;
+    requests_.refill(now);
+    tokens_.refill(now);
+    if (pausedUntil_ > now) {
+        *waitMs = pausedUntil_ - now;
+        return false;
+    }
+    if (inFlight_ >= static_cast<int>(window_)) {
+        *waitMs = 50; // woken early by release()
+        return false;
+    }
+    *waitMs = std::max(requests_.waitFor(1), tokens_.waitFor(tokens));
+    if (*waitMs > 0) return false;
+    requests_.take(1);
+    tokens_.take(tokens);
+    ++inFlight_;
+    return true;
+}
+
+void AdaptiveLimiter::acquire(double tokens, const std::atomic<bool> *stopFlag) {
+    QMutexLocker lock(&mutex_);
+    for (;;) {
+        if (stopFlag && stopFlag->load()) throw std::runtime_error("Process stopped by user.");
+        qint64 waitMs = 0;
+        if (tryTakeLocked(tokens, &waitMs)) return;
+        changed_.wait(&mutex_, static_cast<unsigned long>(std::clamp<qint64>(waitMs, 1, 50)));
+    }
+}
+
+bool AdaptiveLimiter::tryAcquire(double tokens) {
+    QMutexLocker lock(&mutex_);
+    qint64 waitMs = 0;
+    return tryTakeLocked(tokens, &waitMs);
+}
+
+void AdaptiveLimiter::release(Outcome outcome, qint64 latencyMs, int pauseMs) {
+    QMutexLocker lock(&mutex_);
+    inFlight_ = std::max(0, inFlight_ - 1);
+    const double minW = limits_.minConcurrency;
+    const double maxW = limits_.maxConcurrency;
+
+    switch (outcome) {
+    case Outcome::Success:
+        // Latency well above the best recent latency means the provider is queueing us:
+        // back off gently before it turns into 429s.
+        if (baselineLatencyMs_ > 0 && latencyMs > 3 * baselineLatencyMs_) {
+            window_ = std::max(minW, window_ * 0.9);
+        } else {
+            window_ = std::min(maxW, window_ + 1.0 / window_);
+        }
+        baselineLatencyMs_ = baselineLatencyMs_ <= 0
+                                 ? latencyMs
+                                 : std::min<double>(latencyMs, baselineLatencyMs_ * 1.05);
+        break;
+    case Outcome::Throttled:
+        window_ = std::max(minW, window_ / 2);
+        if (pauseMs < 0) pauseMs = 1000;
+        break;
+    case Outcome::Failed:
+        window_ = std::max(minW, window_ * 0.75);
+        break;
+    case Outcome::Cancelled:
+        break;
+    }
+
+    if (pauseMs > 0) {
+        pausedUntil_ = std::max(pausedUntil_, clock_.elapsed() + 1 + pauseMs);
+    }
+    changed_.wakeAll();
+}
+
+RateLimits AdaptiveLimiter::limits() const {
+    QMutexLocker lock(&mutex_);
+    return limits_;
+}
+
+int AdaptiveLimiter::window() const {
+    QMutexLocker lock(&mutex_);
+    return static_cast<int>(window_);
+}
+
+int AdaptiveLimiter::inFlight() const {
+    QMutexLocker lock(&mutex_);
+    return inFlight_;
+}
+
+int parseResetDurationMs(const QByteArray &value) {
+    static const QRegularExpression part("(\\d+(?:\\.\\d+)?)(ms|h|m|s)");
+    const QString v = QString::fromLatin1(value.trimmed());
+    if (v.isEmpty()) return -1;
+    double total = 0;
+    qsizetype consumed = 0;
+    auto it = part.globalMatch(v);
+    while (it.hasNext()) {
+        auto m = it.next();
+        if (m.capturedStart() != consumed) return -1;
+        consumed = m.capturedEnd();
+        const double n = m.captured(1).toDouble();
+        const QString unit = m.captured(2);
+        if (unit == "h") total += n * 3600000;
+        else if (unit == "m") total += n * 60000;
+        else if (unit == "s") total += n * 1000;
+        else total += n;
+    }
+    if (consumed != v.size()) return -1;
+    return static_cast<int>(total);
+}
+
+} // namespace ocr
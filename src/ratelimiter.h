@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+
+namespace ocr {
+
+struct RateLimits {
+    double requestsPerMinute = 0;  // 0 = unlimited
+    double tokensPerMinute = 0;    // 0 = unlimited
+    int minConcurrency = 1;
+    int maxConcurrency = 8;
+    int initialConcurrency = 2;
+};
+
+// AIMD concurrency window plus request/token buckets for one provider. Callers
+// acquire() before sending and release() with the outcome when the reply is in:
+// the window grows by one per window's worth of healthy replies and is cut on 429s,
+// overload errors or latency inflation; rate-limit hints pause new requests until the
+// provider's reset time. Shared by every thread talking to that provider.
+class AdaptiveLimiter {
+public:
+    enum class Outcome { Success, Throttled, Failed, Cancelled };
+
+    explicit AdaptiveLimiter(const RateLimits &limits = RateLimits());
+
+    void setLimits(const RateLimits &limits);
+    RateLimits limits() const;
+
+    // Blocks until an in-flight slot and bucket capacity for `tokens` are free.
+    // Throws std::runtime_error if stopFlag is raised while waiting.
+    void acquire(double tokens, const std::atomic<bool> *stopFlag = nullptr);
+    bool tryAcquire(double tokens);
+
+    // pauseMs >= 0 holds back new requests for that long (Retry-After / reset hints).
+    void release(Outcome outcome, qint64 latencyMs, int pauseMs = -1);
+
+    int window() const;
+    int inFlight() const;
+
+private:
+    struct Bucket {
+        double capacity = 0;  // 0 = disabled
+        double perMs = 0;
+        double level = 0;
+        qint64 last = 0;
+
+        void configure(double perMinute, qint64 now);
+        void refill(qint64 now);
+        qint64 waitFor(double n) const;
+        void take(double n);
+    };
+
+    bool tryTakeLocked(double tokens, qint64 *waitMs);
+
+    mutable QMutex mutex_;
+    QWaitCondition changed_;
+    QElapsedTimer clock_;
+    RateLimits limits_;
+    double window_;
+    int inFlight_;
+    qint64 pausedUntil_;
+    double baselineLatencyMs_;
+    Bucket requests_;
+    Bucket tokens_;
+};
+
+// Parses OpenAI-style reset durations ("1s", "6m0s", "250ms") into milliseconds; -1 if invalid.
+int parseResetDurationMs(const QByteArray &value);
+
+} // namespace ocr
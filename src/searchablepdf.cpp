@@ -0,0 +1,168 @@
+#include "searchablepdf.h"
+#include "outputformats.h"
+#include <QtEndian>
+#include <QtGlobal>
+#include <algorithm>
+
+namespace ocr {
+
+// Every glyph of the glyph-less font is this wide (1/1000 of the font size).
+static constexpr int kGlyphWidth = 500;
+
+static QByteArray num(double v) {
+    return QByteArray::number(v, 'f', 2);
+}
+
+// FlateDecode data: qCompress() output is a zlib stream behind a 4-byte length.
+static QByteArray deflate(const QByteArray &data) {
+    return qCompress(data).mid(4);
+}
+
+// Character codes are UTF-16 units; the ToUnicode map below sends each to itself.
+static QByteArray hexUtf16(const QString &text) {
+    QByteArray hex;
+    hex.reserve(text.size() * 4);
+    for (QChar c : text) hex += QByteArray::number(c.unicode(), 16).rightJustified(4, '0').toUpper();
+    return hex;
+}
+
+static const char kToUnicode[] =
+    "/CIDInit /ProcSet findresource begin\n"
+    "12 dict begin\n"
+    "begincmap\n"
+    "/CIDSystemInfo << /Registry (Adobe) /Ordering (UCS) /Supplement 0 >> def\n"
+    "/CMapName /Adobe-Identify-UCS def\n"
+    "/CMapType 2 def\n"
+    "1 begincodespacerange\n"
+    "<0000> <FFFF>\n"
+    "endcodespacerange\n"
+    "1 beginbfrange\n"
+    "<0000> <FFFF> <0000>\n"
+    "endbfrange\n"
+    "endcmap\n"
+    "CMapName currentdict /CMap defineresource pop\n"
+    "end\n"
+    "end\n";
+
+SearchablePdfWriter::SearchablePdfWriter(Sink sink, const QByteArray &fontData) : sink_(std::move(sink)) {
+    emitBytes("%PDF-1.5\n%\xE2\xE3\xCF\xD3\n");
+    const int catalog = allocate();
+    allocate(); // page tree, written by finish()
+    writeObject(catalog, "<< /Type /Catalog /Pages 2 0 R >>");
+
+    fontObject_ = allocate();
+    const int cidFont = allocate();
+    const int toUnicode = allocate();
+    const int descriptor = allocate();
+    const int cidToGid = fontData.isEmpty() ? 0 : allocate();
+    const int fontFile = fontData.isEmpty() ? 0 : allocate();
+    writeObject(fontObject_, QByteArray("<< /Type /Font /Subtype /Type0 /BaseFont /GlyphLessFont "
+                                        "/Encoding /Identity-H /DescendantFonts [") +
+                                 QByteArray::number(cidFont) + " 0 R] /ToUnicode " +
+                                 QByteArray::number(toUnicode) + " 0 R >>");
+    writeObject(cidFont, QByteArray("<< /Type /Font /Subtype /CIDFontType2 /BaseFont /GlyphLessFont "
+                                    "/CIDSystemInfo << /Registry (Adobe) /Ordering (Identity) /Supplement 0 >> "
+                                    "/FontDescriptor ") +
+                             QByteArray::number(descriptor) + " 0 R /DW " + QByteArray::number(kGlyphWidth) +
+                             " /CIDToGIDMap " +
+                             (cidToGid ? QByteArray::number(cidToGid) + " 0 R" : QByteArray("/Identity")) + " >>");
+    writeStream(toUnicode, QByteArray(), QByteArray(kToUnicode));
+    writeObject(descriptor, QByteArray("<< /Type /FontDescriptor /FontName /GlyphLessFont /Flags 5 "
+                                       "/FontBBox [0 0 ") +
+                                QByteArray::number(kGlyphWidth) +
+                                " 1000] /ItalicAngle 0 /Ascent 1000 /Descent 0 /CapHeight 1000 /StemV 80" +
+                                (fontFile ? " /FontFile2 " + QByteArray::number(fontFile) + " 0 R" : QByteArray()) +
+                                " >>");
+    if (!fontData.isEmpty()) {
+        // Every character code draws the font's one glyph.
+        QByteArray map(65536 * 2, '\0');
+        for (int i = 0; i < 65536; ++i) qToBigEndian<quint16>(1, map.data() + i * 2);
+        writeStream(cidToGid, "/Filter /FlateDecode", deflate(map));
+        writeStream(fontFile, "/Length1 " + QByteArray::number(fontData.size()) + " /Filter /FlateDecode",
+                    deflate(fontData));
+    }
+}
+
+void SearchablePdfWriter::addPage(const PageLayout &layout, const QByteArray &jpeg, const QSize &imageSize,
+                                  bool grayscale, int dpi) {
+    const double scale = 72.0 / std::max(1, dpi);
+    const double width = imageSize.width() * scale;
+    const double height = imageSize.height() * scale;
+
+    QByteArray content = "q " + num(width) + " 0 0 " + num(height) + " 0 0 cm /Im1 Do Q\nBT\n3 Tr\n";
+    for (const LayoutBlock &block : layout.blocks) {
+        for (const LayoutParagraph &paragraph : block.paragraphs) {
+            for (const LayoutLine &line : paragraph.lines) {
+                for (int k = 0; k < line.words.size(); ++k) {
+                    const LayoutWord &word = line.words[k];
+                    if (word.text.isEmpty() || word.box.isEmpty()) continue;
+                    // Each word sits on its box's bottom edge, as tall as the box and
+                    // stretched to its width; the space after it keeps words apart
+                    // when the text is copied.
+                    const double fontSize = std::max(1.0, word.box.height() * scale);
+                    const double natural = word.text.size() * fontSize * kGlyphWidth / 1000.0;
+                    const double stretch = 100.0 * word.box.width() * scale / natural;
+                    const QString text = k + 1 < line.words.size() ? word.text + QLatin1Char(' ') : word.text;
+                    content += "/F1 " + num(fontSize) + " Tf " + num(stretch) + " Tz 1 0 0 1 " +
+                               num(word.box.left() * scale) + ' ' +
+                               num(height - (word.box.top() + word.box.height()) * scale) + " Tm <" +
+                               hexUtf16(text) + "> Tj\n";
+                }
+            }
+        }
+    }
+    content += "ET\n";
+
+    const int image = allocate();
+    const int contents = allocate();
+    const int page = allocate();
+    writeStream(image,
+                "/Type /XObject /Subtype /Image /Width " + QByteArray::number(imageSize.width()) + " /Height " +
+                    QByteArray::number(imageSize.height()) + " /ColorSpace " +
+                    (grayscale ? "/DeviceGray" : "/DeviceRGB") + " /BitsPerComponent 8 /Filter /DCTDecode",
+                jpeg);
+    writeStream(contents, "/Filter /FlateDecode", deflate(content));
+    writeObject(page, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 " + num(width) + ' ' + num(height) +
+                          "] /Contents " + QByteArray::number(contents) + " 0 R /Resources << /XObject << /Im1 " +
+                          QByteArray::number(image) + " 0 R >> /Font << /F1 " + QByteArray::number(fontObject_) +
+                          " 0 R >> >> >>");
+    pages_.append(page);
+}
+
+void SearchablePdfWriter::finish() {
+    QByteArray kids;
+    for (int page : pages_) kids += QByteArray::number(page) + " 0 R ";
+    writeObject(2, "<< /Type /Pages /Kids [" + kids.trimmed() + "] /Count " +
+                       QByteArray::number(pages_.size()) + " >>");
+
+    const qint64 xref = offset_;
+    QByteArray table = "xref\n0 " + QByteArray::number(offsets_.size() + 1) + "\n0000000000 65535 f \n";
+    for (qint64 offset : offsets_) table += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    table += "trailer\n<< /Size " + QByteArray::number(offsets_.size() + 1) + " /Root 1 0 R >>\nstartxref\n" +
+             QByteArray::number(xref) + "\n%%EOF\n";
+    emitBytes(table);
+}
+
+int SearchablePdfWriter::allocate() {
+    offsets_.append(0);
+    return offsets_.size();
+}
+
+void SearchablePdfWriter::writeObject(int number, const QByteArray &body) {
+    offsets_[number - 1] = offset_;
+    emitBytes(QByteArray::number(number) + " 0 obj\n" + body + "\nendobj\n");
+}
+
+void SearchablePdfWriter::writeStream(int number, const QByteArray &dict, const QByteArray &data) {
+    QByteArray head = "<< ";
+    if (!dict.isEmpty()) head += dict + ' ';
+    head += "/Length " + QByteArray::number(data.size()) + " >>\nstream\n";
+    writeObject(number, head + data + "\nendstream");
+}
+
+void SearchablePdfWriter::emitBytes(const QByteArray &bytes) {
+    sink_(bytes);
+    offset_ += bytes.size();
+}
+
+} // namespace ocr
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QSize>
+#include <functional>
+
+namespace ocr {
+
+struct PageLayout;
+
+// Streams a PDF of page images with an invisible text layer, one page at a time,
+// the way Tesseract's PDF renderer builds it: text in render mode 3 with a glyph-less
+// Type0 font whose character codes are UTF-16 units, so any script can be searched
+// and copied. Page objects are written as pages are added; the page tree and cross
+// reference table follow in finish().
+class SearchablePdfWriter {
+public:
+    using Sink = std::function<void(const QByteArray &)>;
+
+    // fontData: a TrueType font with a single glyph (Tesseract's pdf.ttf) to embed;
+    // without it, viewers substitute a font, which is never drawn anyway.
+    explicit SearchablePdfWriter(Sink sink, const QByteArray &fontData = QByteArray());
+
+    // jpeg is the page image, imageSize pixels at dpi; grayscale selects DeviceGray
+    // over DeviceRGB. Word boxes in layout are in the image's pixels.
+    void addPage(const PageLayout &layout, const QByteArray &jpeg, const QSize &imageSize,
+                 bool grayscale, int dpi);
+    void finish();
+
+    int pageCount() const { return pages_.size(); }
+
+private:
+    int allocate();
+    void writeObject(int number, const QByteArray &body);
+    void writeStream(int number, const QByteArray &dict, const QByteArray &data);
+    void emitBytes(const QByteArray &bytes);
+
+    Sink sink_;
+    qint64 offset_ = 0;
+    QList<qint64> offsets_; // by object number - 1
+    QList<int> pages_;
+    int fontObject_ = 0;
+};
+
+} // namespace ocr
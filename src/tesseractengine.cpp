@@ -0,0 +1,58 @@
+#include "tesseractengine.h"
+#include "tesseractpool.h"
+#include "textquality.h"
+#include <stdexcept>
+
+namespace ocr {
+
+TesseractEngine::TesseractEngine(const QString &tessdataDir, const OcrProfile &profile,
+                                 const ThreadBudget &budget, const std::atomic<bool> *stopFlag)
+    : QueuedOcrEngine(budget.pageWorkers, "Tesseract"), tessdataDir_(tessdataDir), profile_(profile),
+      budget_(budget), stopFlag_(stopFlag), pools_(threadCount()) {}
+
+TesseractEngine::~TesseractEngine() {
+    shutdown();
+}
+
+EngineCapabilities TesseractEngine::capabilities() const {
+    EngineCapabilities caps;
+    caps.name = "Tesseract";
+    caps.maxBatchSize = 1;
+    caps.preferredConcurrency = threadCount();
+    caps.cpuBound = true;
+    caps.pixelFormats = {PixelFormat::Gray8};
+    return caps;
+}
+
+void TesseractEngine::startWorker(int worker) {
+    // Each page worker gets its own run of cores for its block engines and their
+    // OpenMP threads, which start on this thread and inherit the set.
+    const int share = budget_.blockThreads * budget_.openMpThreads;
+    if (budget_.pinThreads) pinCurrentThread(worker * share, share);
+}
+
+OcrOutcome TesseractEngine::read(const OcrPage &page, int worker) {
+    if (!page.gray) throw std::runtime_error("Tesseract needs an 8 bpp page.");
+    std::unique_ptr<TesseractPool> &pool = pools_[worker];
+    if (!pool) pool = std::make_unique<TesseractPool>(tessdataDir_, profile_);
+
+    // Only the languages the page's script needs, on engines kept from earlier pages.
+    // OSD costs a pass over a downscaled copy; only pay for it when the answer matters.
+    const QString lang = needsScriptDetection(page.language)
+                             ? languagesForPage(page.language, pool->detectScript(page.gray))
+                             : QString("eng");
+    RenderRequest render;
+    render.formats = page.formats;
+    render.pageNumber = page.pageNumber;
+    render.dpi = page.dpi;
+    const PageText text = pool->recognize(page.gray, lang, stopFlag_, budget_.blockThreads, render);
+    OcrOutcome outcome;
+    outcome.text = text.text;
+    outcome.confidence = text.meanConfidence;
+    outcome.dictionaryHitRate = text.dictionaryHitRate;
+    outcome.renderings = text.renderings;
+    outcome.layout = text.layout;
+    return outcome;
+}
+
+} // namespace ocr
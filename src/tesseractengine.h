@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ocrengine.h"
+#include "ocrprofile.h"
+#include "threadbudget.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace ocr {
+
+class TesseractPool;
+
+// Tesseract behind the OcrEngine interface: budget.pageWorkers threads, each with its
+// own TesseractPool (engines are not thread-safe), recognizing a page with
+// budget.blockThreads engines. Takes 8 bpp pages and picks each page's languages from
+// its detected script (see languagesForPage).
+class TesseractEngine : public QueuedOcrEngine {
+public:
+    TesseractEngine(const QString &tessdataDir, const OcrProfile &profile, const ThreadBudget &budget,
+                    const std::atomic<bool> *stopFlag = nullptr);
+    ~TesseractEngine() override;
+
+    EngineCapabilities capabilities() const override;
+
+protected:
+    OcrOutcome read(const OcrPage &page, int worker) override;
+    void startWorker(int worker) override;
+
+private:
+    QString tessdataDir_;
+    OcrProfile profile_;
+    ThreadBudget budget_;
+    const std::atomic<bool> *stopFlag_;
+    // One per engine thread, created by that thread on its first page.
+    std::vector<std::unique_ptr<TesseractPool>> pools_;
+};
+
+} // namespace ocr
@@ -0,0 +1,364 @@
+#include "tesseractpool.h"
+#include "tracing.h"
+#include "utils.h"
+#include <QThread>
+#include <tesseract/baseapi.h>
+#include <tesseract/version.h>
+#include <tesseract/ocrclass.h>
+#include <tesseract/resultiterator.h>
+#include <leptonica/allheaders.h>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef TESSERACT_MAJOR_VERSION
+#define TESSERACT_MAJOR_VERSION 4
+#endif
+#ifndef TESSERACT_MINOR_VERSION
+#define TESSERACT_MINOR_VERSION 0
+#endif
+// GetAltoText() appeared in 4.1.
+#define TESS_HAS_ALTO (TESSERACT_MAJOR_VERSION > 4 || (TESSERACT_MAJOR_VERSION == 4 && TESSERACT_MINOR_VERSION >= 1))
+
+// ETEXT_DESC moved into namespace tesseract in 5.0; this finds it with either version.
+namespace tesseract {}
+namespace tess_compat {
+using namespace tesseract;
+using Monitor = ETEXT_DESC;
+}
+
+namespace ocr {
+
+// Tesseract polls this while recognizing; returning true abandons Recognize() so a
+// stop request does not wait for the rest of the page.
+static bool cancelRequested(void *stopFlag, int /*words*/) {
+    return stopFlag && static_cast<const std::atomic<bool> *>(stopFlag)->load();
+}
+
+static void recognizeCancellable(tesseract::TessBaseAPI *api, const std::atomic<bool> *stopFlag) {
+    tess_compat::Monitor monitor;
+    monitor.cancel = cancelRequested;
+    monitor.cancel_this = const_cast<std::atomic<bool> *>(stopFlag);
+    api->Recognize(&monitor);
+}
+
+static void countDictionaryWords(tesseract::TessBaseAPI *api, int *words, int *inDictionary) {
+    std::unique_ptr<tesseract::ResultIterator> it(api->GetIterator());
+    if (!it) return;
+    do {
+        if (it->Empty(tesseract::RIL_WORD)) continue;
+        ++*words;
+        if (it->WordIsFromDictionary()) ++*inDictionary;
+    } while (it->Next(tesseract::RIL_WORD));
+}
+
+static QString takeText(tesseract::TessBaseAPI *api) {
+    QString text;
+    if (char *out = api->GetUTF8Text()) {
+        text = QString::fromUtf8(out);
+        delete[] out;
+    }
+    return text;
+}
+
+static QByteArray takeBytes(char *out) {
+    QByteArray bytes(out ? out : "");
+    delete[] out;
+    return bytes;
+}
+
+// Appends the recognized words with their blocks, paragraphs and lines. Boxes are in
+// the coordinates of the whole image, also after SetRectangle().
+static void appendLayout(tesseract::TessBaseAPI *api, PageLayout *layout) {
+    std::unique_ptr<tesseract::ResultIterator> it(api->GetIterator());
+    if (!it) return;
+    auto box = [&it](tesseract::PageIteratorLevel level) {
+        int l = 0, t = 0, r = 0, b = 0;
+        it->BoundingBox(level, &l, &t, &r, &b);
+        return QRect(l, t, r - l, b - t);
+    };
+    do {
+        if (it->Empty(tesseract::RIL_WORD)) continue;
+        if (layout->blocks.isEmpty() || it->IsAtBeginningOf(tesseract::RIL_BLOCK)) {
+            LayoutBlock block;
+            block.box = box(tesseract::RIL_BLOCK);
+            layout->blocks << block;
+        }
+        LayoutBlock &block = layout->blocks.last();
+        if (block.paragraphs.isEmpty() || it->IsAtBeginningOf(tesseract::RIL_PARA)) {
+            LayoutParagraph paragraph;
+            paragraph.box = box(tesseract::RIL_PARA);
+            block.paragraphs << paragraph;
+        }
+        LayoutParagraph &paragraph = block.paragraphs.last();
+        if (paragraph.lines.isEmpty() || it->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) {
+            LayoutLine line;
+            line.box = box(tesseract::RIL_TEXTLINE);
+            paragraph.lines << line;
+        }
+        LayoutWord word;
+        word.box = box(tesseract::RIL_WORD);
+        word.text = QString::fromUtf8(takeBytes(it->GetUTF8Text(tesseract::RIL_WORD)));
+        word.confidence = qRound(it->Confidence(tesseract::RIL_WORD));
+        paragraph.lines.last().words << word;
+    } while (it->Next(tesseract::RIL_WORD));
+}
+
+// Fills in what render asks for from layout: the PDF's word boxes and any text
+// format the engine did not write natively.
+static void renderFromLayout(const RenderRequest &render, PageText *result) {
+    for (OutputFormat format : render.formats) {
+        if (format == OutputFormat::Pdf || result->renderings.contains(format)) continue;
+        result->renderings.insert(format, renderPageFragment(format, result->layout, render.pageNumber, render.dpi));
+    }
+}
+
+// The requested formats while api still holds the page: the fragments Tesseract's
+// hOCR, TSV and ALTO renderers write for it, and the word boxes for the PDF.
+static void renderOutputs(tesseract::TessBaseAPI *api, Pix *page, const RenderRequest &render,
+                          PageText *result) {
+    if (render.formats.isEmpty()) return;
+    TraceSpan span("render_outputs", "pipeline", QString("page %1").arg(render.pageNumber));
+    const int index = render.pageNumber - 1;
+    bool needLayout = false;
+    for (OutputFormat format : render.formats) {
+        switch (format) {
+        case OutputFormat::Hocr:
+            result->renderings.insert(format, takeBytes(api->GetHOCRText(index)));
+            break;
+        case OutputFormat::Tsv:
+            result->renderings.insert(format, takeBytes(api->GetTSVText(index)));
+            break;
+        case OutputFormat::Alto:
+#if TESS_HAS_ALTO
+            result->renderings.insert(format, takeBytes(api->GetAltoText(index)));
+#else
+            needLayout = true;
+#endif
+            break;
+        case OutputFormat::Pdf:
+            needLayout = true;
+            break;
+        }
+    }
+    if (!needLayout) return;
+    result->layout.size = QSize(pixGetWidth(page), pixGetHeight(page));
+    appendLayout(api, &result->layout);
+    renderFromLayout(render, result);
+}
+
+TesseractPool::TesseractPool(const QString &tessdataDir, const OcrProfile &profile)
+    : tessdataDir_(tessdataDir), modelDir_(findModelSetDir(tessdataDir, profile.modelSet)),
+      profile_(profile) {}
+
+tesseract::TessBaseAPI *TesseractPool::createEngine(const QString &lang) {
+    TraceSpan span("tesseract_init", "pipeline", QString("%1 (%2)").arg(lang, profile_.name));
+    auto *api = new tesseract::TessBaseAPI();
+    const QByteArray datapath = modelDir_.toUtf8();
+    const auto mode = static_cast<tesseract::OcrEngineMode>(profile_.engineMode);
+#if TESSERACT_MAJOR_VERSION >= 5
+    std::vector<std::string> names, values;
+    for (const auto &var : profile_.initVariables) {
+        names.emplace_back(var.first.constData());
+        values.emplace_back(var.second.constData());
+    }
+    const int rc = api->Init(datapath.isEmpty() ? nullptr : datapath.constData(),
+                             lang.toUtf8().constData(), mode, nullptr, 0, &names, &values, false);
+#else
+    // Init-time variables (the dictionary switches) need the Tesseract 5 Init() overload.
+    const int rc = api->Init(datapath.isEmpty() ? nullptr : datapath.constData(),
+                             lang.toUtf8().constData(), mode);
+#endif
+    if (rc) {
+        delete api;
+        throw std::runtime_error(
+            QString("Could not initialize tesseract for lang %1 (datapath=%2)")
+                .arg(lang, modelDir_.isEmpty() ? "default" : modelDir_)
+                .toStdString());
+    }
+    for (const auto &var : profile_.variables) {
+        api->SetVariable(var.first.constData(), var.second.constData());
+    }
+    api->SetPageSegMode(static_cast<tesseract::PageSegMode>(profile_.pageSegMode));
+    return api;
+}
+
+TesseractPool::~TesseractPool() {
+    for (tesseract::TessBaseAPI *api : engines_) {
+        api->End();
+        delete api;
+    }
+    for (const QList<tesseract::TessBaseAPI *> &apis : blockEngines_) {
+        for (tesseract::TessBaseAPI *api : apis) {
+            api->End();
+            delete api;
+        }
+    }
+    if (osd_) {
+        osd_->End();
+        delete osd_;
+    }
+}
+
+tesseract::TessBaseAPI *TesseractPool::engine(const QString &lang) {
+    if (tesseract::TessBaseAPI *api = engines_.value(lang)) return api;
+    tesseract::TessBaseAPI *api = createEngine(lang);
+    engines_.insert(lang, api);
+    return api;
+}
+
+QString TesseractPool::detectScript(Pix *page, float minConfidence) {
+    if (osdUnavailable_ || !page) return QString();
+    if (!osd_) {
+        osd_ = new tesseract::TessBaseAPI();
+        const QByteArray datapath = tessdataDir_.toUtf8();
+        if (osd_->Init(datapath.isEmpty() ? nullptr : datapath.constData(), "osd")) {
+            delete osd_;
+            osd_ = nullptr;
+            osdUnavailable_ = true;
+            return QString();
+        }
+        osd_->SetPageSegMode(tesseract::PSM_OSD_ONLY);
+    }
+
+    TraceSpan span("script_detect");
+    // Script detection only needs glyph shapes; a quarter of the pixels is plenty.
+    Pix *small = pixScale(page, 0.5f, 0.5f);
+    if (!small) return QString();
+    osd_->SetImage(small);
+    int orientation = 0;
+    float orientationConf = 0, scriptConf = 0;
+    const char *scriptName = nullptr;
+    const bool ok = osd_->DetectOrientationScript(&orientation, &orientationConf, &scriptName, &scriptConf);
+    osd_->Clear();
+    pixDestroy(&small);
+    if (!ok || !scriptName || scriptConf < minConfidence) return QString();
+    return QString::fromLatin1(scriptName);
+}
+
+PageText TesseractPool::recognize(Pix *page, const QString &lang, const std::atomic<bool> *stopFlag,
+                                  int threads, const RenderRequest &render) {
+    if (threads > 1) return recognizeBlocks(page, lang, stopFlag, threads, render);
+
+    tesseract::TessBaseAPI *api = engine(lang);
+    api->SetImage(page);
+    recognizeCancellable(api, stopFlag);
+    if (stopFlag && stopFlag->load()) {
+        api->Clear();
+        throw std::runtime_error("Process stopped by user.");
+    }
+    PageText result;
+    result.text = takeText(api);
+    result.meanConfidence = api->MeanTextConf();
+    int words = 0, inDictionary = 0;
+    countDictionaryWords(api, &words, &inDictionary);
+    if (words > 0) result.dictionaryHitRate = double(inDictionary) / words;
+    renderOutputs(api, page, render, &result);
+    api->Clear();
+    return result;
+}
+
+PageText TesseractPool::recognizeBlocks(Pix *page, const QString &lang, const std::atomic<bool> *stopFlag,
+                                        int threads, const RenderRequest &render) {
+    struct Block {
+        int left, top, width, height;
+        QString text;
+        int confidence = 0;
+        int words = 0;
+        int inDictionary = 0;
+        PageLayout layout;
+    };
+
+    // Layout analysis runs once on the main engine; its blocks come back in reading order.
+    std::vector<Block> blocks;
+    {
+        TraceSpan span("layout");
+        tesseract::TessBaseAPI *api = engine(lang);
+        api->SetImage(page);
+        std::unique_ptr<tesseract::PageIterator> it(api->AnalyseLayout());
+        if (it) {
+            do {
+                if (!PTIsTextType(it->BlockType())) continue;
+                int l = 0, t = 0, r = 0, b = 0;
+                if (!it->BoundingBox(tesseract::RIL_BLOCK, &l, &t, &r, &b)) continue;
+                blocks.push_back({l, t, r - l, b - t});
+            } while (it->Next(tesseract::RIL_BLOCK));
+        }
+        api->Clear();
+    }
+    if (blocks.size() < 2) return recognize(page, lang, stopFlag, 1, render);
+
+    // Each thread gets its own engine and its own copy of the page: Leptonica's
+    // reference counts are not atomic, so a Pix must not be shared across threads.
+    const int blockCount = static_cast<int>(blocks.size());
+    const int workers = std::min(threads, blockCount);
+    QList<tesseract::TessBaseAPI *> &spares = blockEngines_[lang];
+    while (spares.size() < workers) {
+        tesseract::TessBaseAPI *api = createEngine(lang);
+        api->SetPageSegMode(tesseract::PSM_SINGLE_BLOCK);
+        spares.append(api);
+    }
+
+    std::atomic<int> next(0);
+    QList<QThread *> pool;
+    QList<Pix *> copies;
+    for (int w = 0; w < workers; ++w) {
+        tesseract::TessBaseAPI *api = spares[w];
+        Pix *copy = pixCopy(nullptr, page);
+        copies << copy;
+        const bool wantLayout = !render.formats.isEmpty();
+        QThread *th = QThread::create([&blocks, &next, blockCount, api, copy, stopFlag, wantLayout]() {
+            api->SetImage(copy);
+            for (;;) {
+                const int i = next.fetch_add(1);
+                if (i >= blockCount || (stopFlag && stopFlag->load())) break;
+                Block &block = blocks[i];
+                TraceSpan span("ocr_block", "pipeline", QString("block %1").arg(i + 1));
+                api->SetRectangle(block.left, block.top, block.width, block.height);
+                recognizeCancellable(api, stopFlag);
+                block.text = takeText(api);
+                block.confidence = api->MeanTextConf();
+                countDictionaryWords(api, &block.words, &block.inDictionary);
+                if (wantLayout) appendLayout(api, &block.layout);
+            }
+            api->Clear();
+        });
+        th->setObjectName(QString("OCR block %1").arg(w + 1));
+        pool << th;
+        th->start();
+    }
+    for (QThread *th : pool) {
+        th->wait();
+        delete th;
+    }
+    for (Pix *copy : copies) pixDestroy(&copy);
+    if (stopFlag && stopFlag->load()) throw std::runtime_error("Process stopped by user.");
+
+    PageText result;
+    QStringList parts;
+    qint64 weighted = 0, chars = 0;
+    int words = 0, inDictionary = 0;
+    for (const Block &block : blocks) {
+        if (block.text.trimmed().isEmpty()) continue;
+        parts << block.text.trimmed();
+        weighted += qint64(block.confidence) * block.text.size();
+        chars += block.text.size();
+        words += block.words;
+        inDictionary += block.inDictionary;
+    }
+    result.text = parts.join("\n\n") + (parts.isEmpty() ? "" : "\n");
+    result.meanConfidence = chars > 0 ? int(weighted / chars) : 0;
+    if (words > 0) result.dictionaryHitRate = double(inDictionary) / words;
+    if (!render.formats.isEmpty()) {
+        // Each block engine only saw its own rectangle, so the page's formats are
+        // written from the joined word boxes.
+        result.layout.size = QSize(pixGetWidth(page), pixGetHeight(page));
+        for (const Block &block : blocks) result.layout.blocks += block.layout.blocks;
+        renderFromLayout(render, &result);
+    }
+    return result;
+}
+
+} // namespace ocr
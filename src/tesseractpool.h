@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <atomic>
+#include "ocrprofile.h"
+#include "outputformats.h"
+
+struct Pix;
+namespace tesseract { class TessBaseAPI; }
+
+namespace ocr {
+
+struct PageText {
+    QString text;
+    int meanConfidence = 0;        // mean word confidence, 0-100
+    double dictionaryHitRate = -1; // share of words found in the dictionary; -1 if no words
+    QMap<OutputFormat, QByteArray> renderings; // page fragments in the requested text formats
+    PageLayout layout;                         // word boxes, when a searchable PDF is requested
+};
+
+// Tesseract engines keyed by language string, initialised on first use and kept for
+// the remaining pages (loading a model costs far more than recognising a page). Not
+// thread-safe: one pool per worker thread.
+class TesseractPool {
+public:
+    // Engines use profile's models (see findModelSetDir), engine mode and variables.
+    explicit TesseractPool(const QString &tessdataDir, const OcrProfile &profile = ocrProfile("balanced"));
+    ~TesseractPool();
+
+    TesseractPool(const TesseractPool &) = delete;
+    TesseractPool &operator=(const TesseractPool &) = delete;
+
+    // Throws std::runtime_error if the language data cannot be loaded.
+    tesseract::TessBaseAPI *engine(const QString &lang);
+
+    // Dominant script of page ("Latin", "Devanagari", ...) from orientation and script
+    // detection on a half-resolution copy. Empty when the detection is unsure or
+    // osd.traineddata is not installed.
+    QString detectScript(Pix *page, float minConfidence = 1.0f);
+
+    // Recognizes page with lang. With threads > 1 the layout is analysed once and the
+    // text blocks are recognised concurrently on that many extra engines, then joined
+    // in reading order; pages with a single block take the normal path. Throws
+    // std::runtime_error("Process stopped by user.") when stopFlag is raised mid-page.
+    // The formats in render come from the same pass: hOCR, TSV and ALTO as Tesseract's
+    // renderers write a page (mapped from the word boxes for block-wise pages).
+    PageText recognize(Pix *page, const QString &lang, const std::atomic<bool> *stopFlag,
+                       int threads = 1, const RenderRequest &render = RenderRequest());
+
+private:
+    PageText recognizeBlocks(Pix *page, const QString &lang, const std::atomic<bool> *stopFlag,
+                             int threads, const RenderRequest &render);
+
+    tesseract::TessBaseAPI *createEngine(const QString &lang);
+
+    QString tessdataDir_; // OSD data
+    QString modelDir_;    // recognition models for the profile
+    OcrProfile profile_;
+    QHash<QString, tesseract::TessBaseAPI *> engines_;
+    QHash<QString, QList<tesseract::TessBaseAPI *>> blockEngines_;
+    tesseract::TessBaseAPI *osd_ = nullptr;
+    bool osdUnavailable_ = false;
+};
+
+} // namespace ocr
@@ -0,0 +1,152 @@
+#include "textchunker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ocr {
+
+// Newer OpenAI models use the o200k vocabulary, which has far better coverage of
+// Indic scripts than cl100k-style vocabularies.
+static bool hasLargeVocabulary(const QString &model) {
+    const QString m = model.toLower();
+    return m.contains("gpt-4o") || m.contains("gpt-4.1") || m.contains("gpt-5") ||
+           m.startsWith("o1") || m.startsWith("o3") || m.startsWith("o4");
+}
+
+ModelLimits modelLimits(const QString &model) {
+    const QString m = model.toLower();
+    if (m.contains("gpt-4.1")) return {1047576, 32768};
+    if (m.contains("gpt-4o")) return {128000, 16384};
+    if (m.contains("gpt-5")) return {400000, 128000};
+    if (m.contains("deepseek")) return {64000, 8192};
+    if (m.contains("claude")) return {200000, 8192};
+    return {8192, 4096};
+}
+
+int estimateTokens(QStringView text, const QString &model) {
+    // Roughly four ASCII characters per token for both vocabularies; everything else is
+    // costed per character.
+    const double otherCost = hasLargeVocabulary(model) ? 0.6 : 1.2;
+    qsizetype ascii = 0;
+    qsizetype other = 0;
+    for (QChar c : text) {
+        if (c.unicode() < 0x80) ++ascii;
+        else if (!c.isLowSurrogate()) ++other;
+    }
+    return static_cast<int>(std::ceil(ascii / 4.0 + other * otherCost));
+}
+
+TextChunker::TextChunker(int tokenBudget, const QString &model)
+    : budget_(std::max(tokenBudget, 1)), model_(model) {}
+
+int TextChunker::budgetForModel(const QString &model, int promptTokens, int requested) {
+    return budgetForLimits(modelLimits(model), promptTokens, requested);
+}
+
+int TextChunker::budgetForLimits(const ModelLimits &limits, int promptTokens, int requested) {
+    // Input and output are about the same size, so each gets half of what the prompt and
+    // message framing leave over; the output must also fit the model's output cap.
+    int fromContext = (limits.contextTokens - promptTokens - 256) / 2;
+    int fromOutput = limits.maxOutputTokens * 9 / 10;
+    int budget = std::min(fromContext, fromOutput);
+    if (requested > 0) budget = std::min(budget, requested);
+    return std::max(budget, 256);
+}
+
+QVector<TextChunk> TextChunker::addPage(const QString &pageText, int pageNumber) {
+    QVector<TextChunk> out;
+    // Close a mostly-full chunk at the page break rather than splitting this page
+    // across two requests.
+    if (current_.estimatedTokens >= budget_ * 3 / 4) flush(out);
+
+    const QStringView view(pageText);
+    qsizetype pos = 0;
+    qsizetype paraStart = 0;
+    qsizetype paraEnd = 0;
+    bool inPara = false;
+    while (pos <= view.size()) {
+        qsizetype nl = view.indexOf(u'\n', pos);
+        if (nl < 0) nl = view.size();
+        if (view.mid(pos, nl - pos).trimmed().isEmpty()) {
+            if (inPara) {
+                appendParagraph(view.mid(paraStart, paraEnd - paraStart).trimmed(), pageNumber, out);
+                inPara = false;
+            }
+        } else {
+            if (!inPara) {
+                paraStart = pos;
+                inPara = true;
+            }
+            paraEnd = nl;
+        }
+        pos = nl + 1;
+    }
+    if (inPara) {
+        appendParagraph(view.mid(paraStart, paraEnd - paraStart).trimmed(), pageNumber, out);
+    }
+    return out;
+}
+
+QVector<TextChunk> TextChunker::finish() {
+    QVector<TextChunk> out;
+    flush(out);
+    return out;
+}
+
+void TextChunker::appendParagraph(QStringView para, int pageNumber, QVector<TextChunk> &out) {
+    if (para.isEmpty()) return;
+    const int tokens = estimateTokens(para, model_);
+    if (tokens > budget_) {
+        flush(out);
+        splitOversized(para, pageNumber, out);
+        return;
+    }
+    if (current_.estimatedTokens + tokens > budget_) flush(out);
+
+    if (current_.text.isEmpty()) {
+        current_.firstPage = pageNumber;
+    } else {
+        current_.text += QLatin1String("\n\n");
+    }
+    current_.text += para;
+    current_.lastPage = pageNumber;
+    current_.estimatedTokens += tokens;
+}
+
+void TextChunker::splitOversized(QStringView para, int pageNumber, QVector<TextChunk> &out) {
+    qsizetype start = 0;
+    qsizetype i = 0;
+    int acc = 0;
+    auto emitPiece = [&](qsizetype end) {
+        QStringView piece = para.mid(start, end - start).trimmed();
+        if (!piece.isEmpty()) out.append({piece.toString(), pageNumber, pageNumber, acc});
+    };
+    while (i < para.size()) {
+        qsizetype next = i;
+        while (next < para.size() && !para[next].isSpace()) ++next;
+        while (next < para.size() && para[next].isSpace()) ++next;
+        const int tokens = estimateTokens(para.mid(i, next - i), model_);
+        if (acc + tokens > budget_ && i > start) {
+            emitPiece(i);
+            start = i;
+            acc = 0;
+        }
+        acc += tokens;
+        i = next;
+    }
+    emitPiece(para.size());
+}
+
+void TextChunker::flush(QVector<TextChunk> &out) {
+    if (current_.text.isEmpty()) return;
+    out.append(std::move(current_));
+    current_ = TextChunk();
+}
+
+QVector<TextChunk> chunkText(const QString &text, int tokenBudget, const QString &model) {
+    TextChunker chunker(tokenBudget, model);
+    QVector<TextChunk> chunks = chunker.addPage(text, 1);
+    chunks += chunker.finish();
+    return chunks;
+}
+
+} // namespace ocr
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+namespace ocr {
+
+struct ModelLimits {
+    int contextTokens;
+    int maxOutputTokens;
+};
+
+// Context window and output cap for a chat model name (e.g. "gpt-4o",
+// "deepseek/deepseek-chat"). Unknown models get a conservative 8k/4k.
+ModelLimits modelLimits(const QString &model);
+
+// Cheap tokenizer-free estimate of how many tokens text costs for model. Errs on the
+// high side for Indic scripts, which the BPE vocabularies split into many pieces.
+int estimateTokens(QStringView text, const QString &model = QString());
+
+struct TextChunk {
+    QString text;
+    int firstPage = -1;
+    int lastPage = -1;
+    int estimatedTokens = 0;
+};
+
+// Packs OCR text into LLM-sized chunks in a single pass. Chunks are filled up to the
+// token budget and only broken at paragraph boundaries; a chunk that is mostly full is
+// closed at the next page break instead of spilling a page across two requests.
+// Paragraphs larger than the budget are split at whitespace.
+//
+// Pages are fed one at a time as OCR produces them; completed chunks come back from
+// addPage() and the remainder from finish().
+class TextChunker {
+public:
+    TextChunker(int tokenBudget, const QString &model = QString());
+
+    QVector<TextChunk> addPage(const QString &pageText, int pageNumber);
+    QVector<TextChunk> finish();
+
+    int tokenBudget() const { return budget_; }
+
+    // Chunk budget that leaves room in model's context for the prompt and an output of
+    // the same size as the input (the correction prompts return the full text).
+    // requested > 0 caps the result.
+    static int budgetForModel(const QString &model, int promptTokens, int requested = 0);
+    // Same for a model whose limits are configured rather than known by name.
+    static int budgetForLimits(const ModelLimits &limits, int promptTokens, int requested = 0);
+
+private:
+    void appendParagraph(QStringView para, int pageNumber, QVector<TextChunk> &out);
+    void splitOversized(QStringView para, int pageNumber, QVector<TextChunk> &out);
+    void flush(QVector<TextChunk> &out);
+
+    int budget_;
+    QString model_;
+    TextChunk current_;
+};
+
+// Convenience wrapper: chunks a whole document with no page information.
+QVector<TextChunk> chunkText(const QString &text, int tokenBudget, const QString &model = QString());
+
+} // namespace ocr
@@ -0,0 +1,163 @@
+#include "textnormalizer.h"
+#include "textchunker.h"
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace ocr {
+
+QString edgeSignature(const QString &line) {
+    QString sig;
+    sig.reserve(line.size());
+    bool inDigits = false;
+    bool inSpace = false;
+    for (QChar c : line.trimmed()) {
+        if (c.isDigit()) {
+            if (!inDigits) sig += u'#';
+            inDigits = true;
+            inSpace = false;
+            continue;
+        }
+        inDigits = false;
+        if (c.isSpace()) {
+            if (!inSpace) sig += u' ';
+            inSpace = true;
+            continue;
+        }
+        inSpace = false;
+        sig += c.toLower();
+    }
+    return sig;
+}
+
+bool isPageNumberLine(const QString &line) {
+    static const QRegularExpression arabic(
+        "^[\\s\\-\\x{2013}\\x{2014}\\[\\](){}|.]*(?:page|p\\.|pg\\.?)?\\s*\\d{1,4}"
+        "(?:\\s*(?:of|/)\\s*\\d{1,4})?[\\s\\-\\x{2013}\\x{2014}\\[\\](){}|.]*$",
+        QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression roman(
+        "^[\\s\\-\\x{2013}\\x{2014}]*(?=[ivxlc])c{0,3}(?:xc|xl|l?x{0,3})(?:ix|iv|v?i{0,3})"
+        "[\\s\\-\\x{2013}\\x{2014}.]*$",
+        QRegularExpression::CaseInsensitiveOption);
+    return arabic.match(line).hasMatch() || roman.match(line).hasMatch();
+}
+
+QString joinHyphenatedLines(const QString &text) {
+    QString out;
+    out.reserve(text.size());
+    const qsizetype n = text.size();
+    for (qsizetype i = 0; i < n; ++i) {
+        const QChar c = text[i];
+        // "-" or a soft hyphen ending a line right after a letter...
+        if ((c == u'-' || c == QChar(0x00AD)) && i > 0 && text[i - 1].isLetter()) {
+            qsizetype j = i + 1;
+            while (j < n && (text[j] == u' ' || text[j] == u'\t')) ++j;
+            if (j < n && text[j] == u'\n') {
+                qsizetype k = j + 1;
+                while (k < n && (text[k] == u' ' || text[k] == u'\t')) ++k;
+                // ...and the word going on in lower case on the next line.
+                if (k < n && text[k].isLower()) {
+                    i = k - 1;
+                    continue;
+                }
+            }
+        }
+        out += c;
+    }
+    return out;
+}
+
+TextNormalizer::TextNormalizer(const NormalizationOptions &options, const QString &model)
+    : options_(options), model_(model) {
+    options_.edgeLines = std::max(0, options_.edgeLines);
+    options_.window = std::max(1, options_.window);
+    options_.minRepeats = std::max(2, options_.minRepeats);
+}
+
+QVector<NormalizedPage> TextNormalizer::addPage(const QString &pageText, int pageNumber) {
+    Page page;
+    page.pageNumber = pageNumber;
+    page.tokens = estimateTokens(pageText, model_);
+
+    static const QRegularExpression spaceRun("[ \\t\\x{00A0}\\x{2000}-\\x{200A}\\x{3000}]+");
+    const QString nfc = pageText.normalized(QString::NormalizationForm_C);
+    for (QString line : nfc.split(u'\n')) {
+        line.replace(spaceRun, " ");
+        page.lines << line.trimmed();
+    }
+
+    QList<int> nonEmpty;
+    for (int i = 0; i < page.lines.size(); ++i) {
+        if (!page.lines[i].isEmpty()) nonEmpty << i;
+    }
+    // Short pages have short edges, so body lines are not mistaken for headers.
+    const int edge = std::min<int>({options_.edgeLines, std::max<int>(1, int(nonEmpty.size()) / 3),
+                                    int(nonEmpty.size())});
+    for (int i = 0; i < edge; ++i) page.edges << nonEmpty[i];
+    for (int i = nonEmpty.size() - edge; i < nonEmpty.size(); ++i) {
+        if (!page.edges.contains(nonEmpty[i])) page.edges << nonEmpty[i];
+    }
+    for (int index : page.edges) {
+        const QString sig = edgeSignature(page.lines[index]);
+        if (sig.size() >= 3) page.signatures.insert(sig);
+    }
+    pending_.push_back(std::move(page));
+
+    QVector<NormalizedPage> out;
+    while (int(pending_.size()) > options_.window) {
+        out.append(release(pending_.front()));
+        released_.push_back(pending_.front().signatures);
+        if (int(released_.size()) > options_.window) released_.pop_front();
+        pending_.pop_front();
+    }
+    return out;
+}
+
+QVector<NormalizedPage> TextNormalizer::finish() {
+    QVector<NormalizedPage> out;
+    while (!pending_.empty()) {
+        out.append(release(pending_.front()));
+        released_.push_back(pending_.front().signatures);
+        if (int(released_.size()) > options_.window) released_.pop_front();
+        pending_.pop_front();
+    }
+    return out;
+}
+
+NormalizedPage TextNormalizer::release(const Page &page) {
+    QStringList lines = page.lines;
+    for (int index : page.edges) {
+        const QString &line = lines[index];
+        bool drop = options_.stripPageNumbers && isPageNumberLine(line);
+        if (!drop && options_.stripHeadersFooters) {
+            const QString sig = edgeSignature(line);
+            if (page.signatures.contains(sig)) {
+                // pending_.front() is page itself; the rest come after it.
+                int seen = 1;
+                for (const QSet<QString> &other : released_) seen += other.contains(sig);
+                for (size_t i = 1; i < pending_.size(); ++i) seen += pending_[i].signatures.contains(sig);
+                drop = seen >= options_.minRepeats;
+            }
+        }
+        if (drop) lines[index].clear();
+    }
+
+    // One blank line between paragraphs, none at the ends.
+    QString text;
+    bool blank = false;
+    for (const QString &line : lines) {
+        if (line.isEmpty()) {
+            blank = !text.isEmpty();
+            continue;
+        }
+        if (!text.isEmpty()) text += blank ? QStringLiteral("\n\n") : QStringLiteral("\n");
+        text += line;
+        blank = false;
+    }
+    if (options_.joinHyphenation) text = joinHyphenatedLines(text);
+
+    tokensBefore_ += page.tokens;
+    tokensAfter_ += estimateTokens(text, model_);
+    return {text, page.pageNumber};
+}
+
+} // namespace ocr
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <deque>
+
+namespace ocr {
+
+struct NormalizationOptions {
+    bool stripHeadersFooters = true; // lines repeated at the top/bottom of nearby pages
+    bool stripPageNumbers = true;    // "12", "- 12 -", "Page 3 of 40", "xiv" at a page edge
+    bool joinHyphenation = true;     // "exam-\nple" -> "example"
+    int edgeLines = 2;               // non-empty lines at each page edge checked
+    int window = 3;                  // pages on either side compared with a page
+    int minRepeats = 3;              // pages (this one included) a line must be on
+};
+
+struct NormalizedPage {
+    QString text;
+    int pageNumber = -1;
+};
+
+// Local cleanup of OCR text before it is chunked for the LLM: NFC normalization,
+// trailing/repeated whitespace, de-hyphenation of words broken across lines, running
+// headers/footers and page numbers. Headers are recognised by comparing a page's edge
+// lines with up to `window` pages before and after it (digits ignored, so "Page 7 of
+// 40" matches "Page 8 of 40"); a page is therefore released only once that many later
+// pages have arrived, or on finish().
+class TextNormalizer {
+public:
+    explicit TextNormalizer(const NormalizationOptions &options = NormalizationOptions(),
+                            const QString &model = QString());
+
+    QVector<NormalizedPage> addPage(const QString &pageText, int pageNumber);
+    // Releases the held-back pages. Pages added afterwards are still compared with the
+    // ones released before.
+    QVector<NormalizedPage> finish();
+
+    // Estimated tokens (see estimateTokens) removed from the pages released so far.
+    int tokensSaved() const { return tokensBefore_ - tokensAfter_; }
+    int tokensBefore() const { return tokensBefore_; }
+
+private:
+    struct Page {
+        int pageNumber;
+        int tokens;
+        QStringList lines;
+        QList<int> edges;        // indices of the edge lines in lines
+        QSet<QString> signatures;
+    };
+
+    NormalizedPage release(const Page &page);
+
+    NormalizationOptions options_;
+    QString model_;
+    std::deque<Page> pending_;
+    std::deque<QSet<QString>> released_; // edge signatures of the last released pages
+    int tokensBefore_ = 0;
+    int tokensAfter_ = 0;
+};
+
+// Edge line reduced for comparison: lower case, digit runs as "#", single spaces.
+QString edgeSignature(const QString &line);
+bool isPageNumberLine(const QString &line);
+// Joins words hyphenated across a line break when the next line continues in lower case.
+QString joinHyphenatedLines(const QString &text);
+
+} // namespace ocr
@@ -0,0 +1,118 @@
+#include "textquality.h"
+#include <QHash>
+#include <QStringList>
+#include <algorithm>
+
+namespace ocr {
+
+QList<QChar::Script> scriptsForLanguage(const QString &tessLang) {
+    static const QHash<QString, QList<QChar::Script>> scripts = {
+        {"eng", {QChar::Script_Latin}},
+        {"san", {QChar::Script_Devanagari, QChar::Script_Latin}}, // IAST transliteration too
+        {"hin", {QChar::Script_Devanagari}},
+        {"mar", {QChar::Script_Devanagari}},
+        {"nep", {QChar::Script_Devanagari}},
+        {"kok", {QChar::Script_Devanagari}},
+        {"guj", {QChar::Script_Gujarati}},
+        {"pan", {QChar::Script_Gurmukhi}},
+        {"ben", {QChar::Script_Bengali}},
+        {"asm", {QChar::Script_Bengali}},
+        {"ori", {QChar::Script_Oriya}},
+        {"tel", {QChar::Script_Telugu}},
+        {"kan", {QChar::Script_Kannada}},
+        {"tam", {QChar::Script_Tamil}},
+        {"mal", {QChar::Script_Malayalam}},
+        {"sin", {QChar::Script_Sinhala}},
+    };
+    QList<QChar::Script> out;
+    for (const QString &lang : tessLang.split('+', Qt::SkipEmptyParts)) {
+        for (QChar::Script script : scripts.value(lang.trimmed())) {
+            if (!out.contains(script)) out.append(script);
+        }
+    }
+    return out;
+}
+
+QString languagesForPage(const QString &selectedLang, const QString &osdScript) {
+    static const QHash<QString, QChar::Script> osdScripts = {
+        {"Latin", QChar::Script_Latin},         {"Devanagari", QChar::Script_Devanagari},
+        {"Gujarati", QChar::Script_Gujarati},   {"Gurmukhi", QChar::Script_Gurmukhi},
+        {"Bengali", QChar::Script_Bengali},     {"Oriya", QChar::Script_Oriya},
+        {"Telugu", QChar::Script_Telugu},       {"Kannada", QChar::Script_Kannada},
+        {"Tamil", QChar::Script_Tamil},         {"Malayalam", QChar::Script_Malayalam},
+        {"Sinhala", QChar::Script_Sinhala},
+    };
+    const QString selected = selectedLang.isEmpty() ? QString("eng") : selectedLang;
+    const QStringList langs = selected.split('+', Qt::SkipEmptyParts);
+    const QString withEnglish = langs.contains("eng") ? selected : selected + "+eng";
+    if (!needsScriptDetection(selected)) return selected;
+    if (!osdScripts.contains(osdScript)) return withEnglish;
+
+    const QChar::Script script = osdScripts.value(osdScript);
+    const QList<QChar::Script> selectedScripts = scriptsForLanguage(selected);
+    if (script == QChar::Script_Latin) {
+        // A Latin page in a language that is also written in Latin (IAST Sanskrit)
+        // still needs the language's own model for its diacritics.
+        return selectedScripts.contains(QChar::Script_Latin) ? withEnglish : QString("eng");
+    }
+    if (selectedScripts.contains(script)) {
+        QStringList own = langs;
+        own.removeAll("eng");
+        return own.join('+');
+    }
+    return withEnglish;
+}
+
+bool needsScriptDetection(const QString &selectedLang) {
+    return !selectedLang.isEmpty() && selectedLang != "eng";
+}
+
+static bool isOrdinaryPunctuation(char32_t c) {
+    switch (c) {
+    case '.': case ',': case ';': case ':': case '!': case '?': case '\'': case '"':
+    case '(': case ')': case '[': case ']': case '-': case '/':
+    case 0x2013: case 0x2014: case 0x2018: case 0x2019: case 0x201C: case 0x201D:
+    case 0x0964: case 0x0965: // danda, double danda
+        return true;
+    default:
+        return false;
+    }
+}
+
+TextQuality assessTextQuality(QStringView text, const QList<QChar::Script> &expectedScripts,
+                              double ocrConfidence, double dictionaryHitRate) {
+    TextQuality q;
+    q.ocrConfidence = ocrConfidence;
+    q.dictionaryHitRate = dictionaryHitRate;
+
+    qsizetype letters = 0, inScript = 0, visible = 0, noise = 0;
+    for (char32_t c : text.toUcs4()) {
+        if (QChar::isSpace(c)) continue;
+        ++visible;
+        if (QChar::isLetter(c)) {
+            ++letters;
+            if (expectedScripts.isEmpty() || expectedScripts.contains(QChar::script(c))) ++inScript;
+        } else if (!QChar::isDigit(c) && !QChar::isMark(c) && !isOrdinaryPunctuation(c)) {
+            ++noise; // includes U+FFFD and the |~^ debris of misread rules and specks
+        }
+    }
+    if (visible == 0) return q;
+
+    q.scriptConsistency = letters > 0 ? double(inScript) / letters : 0;
+    q.symbolNoise = double(noise) / visible;
+
+    // Weighted mean over the signals that are available.
+    double sum = 0, weight = 0;
+    auto add = [&](double value, double w) {
+        sum += std::clamp(value, 0.0, 1.0) * w;
+        weight += w;
+    };
+    if (ocrConfidence >= 0) add(ocrConfidence / 100.0, 0.4);
+    if (dictionaryHitRate >= 0) add(dictionaryHitRate, 0.3);
+    add(q.scriptConsistency, 0.2);
+    add(1.0 - 5.0 * q.symbolNoise, 0.1); // 20% stray symbols is as bad as it gets
+    q.score = sum / weight;
+    return q;
+}
+
+} // namespace ocr
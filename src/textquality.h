@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QChar>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+namespace ocr {
+
+// Local estimate of how much a page of OCR text would gain from LLM correction.
+// Signals an engine cannot provide are left at -1 and ignored by the score.
+struct TextQuality {
+    double ocrConfidence = -1;      // engine's mean word confidence, 0-100
+    double dictionaryHitRate = -1;  // share of words the engine found in its dictionary
+    double scriptConsistency = 1;   // share of letters written in the page's expected scripts
+    double symbolNoise = 0;         // share of visible characters that are stray symbols
+    double score = 1;               // weighted combination, 0 (garbled) to 1 (clean)
+};
+
+// Scripts a Tesseract language string ("hin+eng", "san") is written in; empty if unknown.
+QList<QChar::Script> scriptsForLanguage(const QString &tessLang);
+
+// Smallest Tesseract language string for a page whose dominant script OSD reported as
+// osdScript ("Latin", "Devanagari", ...): "eng" for a Latin page, selectedLang alone when
+// the page is in its script, otherwise (or with no detection) selectedLang+eng.
+QString languagesForPage(const QString &selectedLang, const QString &osdScript);
+// Whether languagesForPage() depends on the detected script for selectedLang, i.e.
+// whether an OSD pass over the page is worth running. False for plain English.
+bool needsScriptDetection(const QString &selectedLang);
+
+// Scores text; blank text counts as clean since there is nothing to correct.
+TextQuality assessTextQuality(QStringView text, const QList<QChar::Script> &expectedScripts,
+                              double ocrConfidence = -1, double dictionaryHitRate = -1);
+
+} // namespace ocr
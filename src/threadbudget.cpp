@@ -0,0 +1,81 @@
+#include "threadbudget.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtGlobal>
+#include <algorithm>
+#if defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace ocr {
+
+ThreadBudget planThreads(int totalThreads, int pages, int blockThreads, int openMpThreads,
+                         bool pinThreads) {
+    ThreadBudget budget;
+    const int total = totalThreads > 0 ? totalThreads : std::max(1, QThread::idealThreadCount());
+    budget.pinThreads = pinThreads;
+    if (openMpThreads <= 0) {
+        // No limit: outer workers first, OpenMP may use whatever they leave.
+        budget.pageWorkers = std::clamp(pages, 1, total);
+        budget.blockThreads = std::clamp(blockThreads, 1, total / budget.pageWorkers);
+        budget.openMpThreads = std::max(1, total / (budget.pageWorkers * budget.blockThreads));
+        return budget;
+    }
+    budget.openMpThreads = std::clamp(openMpThreads, 1, total);
+    const int outer = std::max(1, total / budget.openMpThreads);
+    // Whole pages first; block threads only get the cores pages alone cannot fill.
+    budget.pageWorkers = std::clamp(pages, 1, outer);
+    budget.blockThreads = std::clamp(blockThreads, 1, outer / budget.pageWorkers);
+    return budget;
+}
+
+// Guards the variable until it is frozen, as nothing may change it while OpenMP reads it.
+static QMutex openMpMutex;
+static bool openMpFrozen = false;
+
+bool setOpenMpThreadLimit(int threads) {
+    QMutexLocker lock(&openMpMutex);
+    if (openMpFrozen) return false;
+    qputenv("OMP_THREAD_LIMIT", QByteArray::number(std::max(1, threads)));
+    return true;
+}
+
+int freezeOpenMpThreadLimit() {
+    QMutexLocker lock(&openMpMutex);
+    openMpFrozen = true;
+    return openMpThreadLimit();
+}
+
+int openMpThreadLimit() {
+    return qEnvironmentVariableIntValue("OMP_THREAD_LIMIT");
+}
+
+bool pinCurrentThread(int firstCpu, int count) {
+    const int cpus = std::max(1, QThread::idealThreadCount());
+    firstCpu = ((firstCpu % cpus) + cpus) % cpus;
+    count = std::clamp(count, 1, cpus);
+#if defined(Q_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < count; ++i) CPU_SET((firstCpu + i) % cpus, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(Q_OS_WIN)
+    const int bits = int(sizeof(DWORD_PTR) * 8);
+    DWORD_PTR mask = 0;
+    for (int i = 0; i < count; ++i) {
+        const int cpu = (firstCpu + i) % cpus;
+        if (cpu < bits) mask |= DWORD_PTR(1) << cpu;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    Q_UNUSED(firstCpu);
+    Q_UNUSED(count);
+    return false;
+#endif
+}
+
+} // namespace ocr
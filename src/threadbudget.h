@@ -0,0 +1,40 @@
+#pragma once
+
+namespace ocr {
+
+// How a job's cores are shared out. Outer parallelism (whole pages on separate
+// workers, then text blocks within a page) scales almost linearly because the
+// engines share nothing; Tesseract's own OpenMP loops are few and narrow, so they
+// get the cores the pages and blocks leave.
+struct ThreadBudget {
+    int pageWorkers = 1;    // pages recognized at the same time
+    int blockThreads = 1;   // engines per page working on its text blocks
+    int openMpThreads = 1;  // per engine: OMP_THREAD_LIMIT if set, else the cores left over
+    bool pinThreads = false;
+};
+
+// Splits totalThreads (<= 0: every core) for a job of `pages` pages, allowing up to
+// blockThreads engines per page, given the process-wide OpenMP limit in force (<= 0:
+// none, so OpenMP is left the cores pages and blocks cannot fill, e.g. on a one-page
+// job). pageWorkers * blockThreads * openMpThreads never exceeds the total.
+ThreadBudget planThreads(int totalThreads, int pages, int blockThreads, int openMpThreads,
+                         bool pinThreads = false);
+
+// The OpenMP runtime reads OMP_THREAD_LIMIT once, when Tesseract first uses it, so the
+// limit can only be chosen before that; after freezeOpenMpThreadLimit() it stays put.
+// Unless the user asks for a split it stays unset.
+
+// Sets OMP_THREAD_LIMIT to threads; returns false, changing nothing, once frozen.
+bool setOpenMpThreadLimit(int threads);
+// Called before the first Tesseract recognition; returns the limit it fixes (0 if unset).
+int freezeOpenMpThreadLimit();
+// The limit in force (OMP_THREAD_LIMIT), or 0 if unset.
+int openMpThreadLimit();
+
+// Binds the calling thread to count CPUs from firstCpu on, wrapping around (Linux and
+// Windows). Threads it starts later inherit the set, so a page worker pinned to its
+// share keeps its block threads and their OpenMP threads there too. Returns false
+// where unsupported or refused.
+bool pinCurrentThread(int firstCpu, int count = 1);
+
+} // namespace ocr
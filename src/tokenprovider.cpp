@@ -0,0 +1,225 @@
+#include "tokenprovider.h"
+#include "httpclient.h"
+#include "tracing.h"
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <ctime>
+#include <stdexcept>
+
+namespace ocr {
+
+static QByteArray base64UrlEncode(const QByteArray &input) {
+    return input.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+}
+
+static QByteArray signWithPrivateKey(EVP_PKEY *pkey, const QByteArray &data) {
+    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    if (!mdctx) return QByteArray();
+
+    QByteArray signature;
+    size_t siglen = 0;
+    if (EVP_DigestSignInit(mdctx, NULL, EVP_sha256(), NULL, pkey) == 1 &&
+        EVP_DigestSignUpdate(mdctx, data.constData(), data.size()) == 1 &&
+        EVP_DigestSignFinal(mdctx, NULL, &siglen) == 1) {
+        signature.resize(static_cast<qsizetype>(siglen));
+        if (EVP_DigestSignFinal(mdctx, reinterpret_cast<unsigned char *>(signature.data()),
+                                &siglen) == 1) {
+            signature.resize(static_cast<qsizetype>(siglen));
+        } else {
+            signature.clear();
+        }
+    }
+    EVP_MD_CTX_free(mdctx);
+    return signature;
+}
+
+GoogleTokenProvider::GoogleTokenProvider(const QString &serviceAccountPath, const QUrl &tokenUrl)
+    : serviceAccountPath_(serviceAccountPath), tokenUrl_(tokenUrl), privateKey_(nullptr),
+      context_(nullptr), netman_(nullptr), refreshTimer_(nullptr), failureCount_(0), expiry_(0) {
+    QFile f(serviceAccountPath);
+    if (!f.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error("Failed to open service account JSON file.");
+    }
+    QJsonDocument jd = QJsonDocument::fromJson(f.readAll());
+    f.close();
+    if (!jd.isObject()) {
+        throw std::runtime_error("Invalid service account JSON.");
+    }
+    QJsonObject obj = jd.object();
+    clientEmail_ = obj.value("client_email").toString();
+    QByteArray pem = obj.value("private_key").toString().toUtf8();
+    if (clientEmail_.isEmpty() || pem.isEmpty()) {
+        throw std::runtime_error("Service account JSON missing required fields.");
+    }
+
+    BIO *bio = BIO_new_mem_buf(pem.constData(), pem.size());
+    if (bio) {
+        privateKey_ = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
+        BIO_free(bio);
+    }
+    if (!privateKey_) {
+        throw std::runtime_error("Failed to parse service account private key.");
+    }
+}
+
+GoogleTokenProvider::~GoogleTokenProvider() {
+    if (thread_.isRunning()) {
+        thread_.quit();
+        thread_.wait();
+    }
+    EVP_PKEY_free(privateKey_);
+}
+
+void GoogleTokenProvider::start() {
+    if (context_) return;
+    context_ = new QObject();
+    context_->moveToThread(&thread_);
+    QObject::connect(&thread_, &QThread::finished, context_, &QObject::deleteLater);
+    thread_.setObjectName("OAuthRefresh");
+    thread_.start();
+
+    QMetaObject::invokeMethod(context_, [this]() {
+        netman_ = new QNetworkAccessManager(context_);
+        refreshTimer_ = new QTimer(context_);
+        refreshTimer_->setSingleShot(true);
+        QObject::connect(refreshTimer_, &QTimer::timeout, context_, [this]() { refresh(); });
+        refresh();
+    }, Qt::QueuedConnection);
+}
+
+QString GoogleTokenProvider::token() const {
+    QMutexLocker lock(&mutex_);
+    if (!token_.isEmpty() && expiry_ > std::time(nullptr) + 30) return token_;
+    return QString();
+}
+
+QString GoogleTokenProvider::waitForToken(int timeoutMs, const std::atomic<bool> *stopFlag) const {
+    QDeadlineTimer deadline(timeoutMs);
+    QMutexLocker lock(&mutex_);
+    for (;;) {
+        if (!token_.isEmpty() && expiry_ > std::time(nullptr) + 30) return token_;
+        if (permanentError_) {
+            throw std::runtime_error(
+                QString("Failed to authenticate with Google Cloud: %1").arg(lastError_).toStdString());
+        }
+        if (stopFlag && stopFlag->load()) throw std::runtime_error("Process stopped by user.");
+        if (deadline.hasExpired()) {
+            // A retry is still scheduled; the next job may get a token.
+            if (!lastError_.isEmpty()) {
+                throw std::runtime_error(QString("Timed out waiting for a Google Cloud access token (%1).")
+                                             .arg(lastError_).toStdString());
+            }
+            throw std::runtime_error("Timed out waiting for a Google Cloud access token.");
+        }
+        tokenReady_.wait(&mutex_, 100);
+    }
+}
+
+QByteArray GoogleTokenProvider::signedAssertion() const {
+    qint64 iat = std::time(nullptr);
+
+    QJsonObject header;
+    header["alg"] = "RS256";
+    header["typ"] = "JWT";
+
+    QJsonObject claim;
+    claim["iss"] = clientEmail_;
+    claim["scope"] = "https://www.googleapis.com/auth/cloud-platform";
+    claim["aud"] = "https://oauth2.googleapis.com/token";
+    claim["exp"] = (double)(iat + 3600);
+    claim["iat"] = (double)iat;
+
+    QByteArray unsignedJwt = base64UrlEncode(QJsonDocument(header).toJson(QJsonDocument::Compact)) +
+                             "." +
+                             base64UrlEncode(QJsonDocument(claim).toJson(QJsonDocument::Compact));
+    QByteArray signature = signWithPrivateKey(privateKey_, unsignedJwt);
+    if (signature.isEmpty()) return QByteArray();
+    return unsignedJwt + "." + base64UrlEncode(signature);
+}
+
+void GoogleTokenProvider::scheduleRefresh(int delayMs) {
+    refreshTimer_->start(delayMs);
+}
+
+void GoogleTokenProvider::fail(const QString &error, bool permanent) {
+    {
+        QMutexLocker lock(&mutex_);
+        lastError_ = error;
+        permanentError_ = permanent;
+    }
+    tokenReady_.wakeAll();
+    // Keep trying in the background; even a rejected key may be re-enabled.
+    ++failureCount_;
+    scheduleRefresh(qMin(300000, 5000 << qMin(failureCount_, 6)));
+}
+
+// Runs on thread_. The token request is asynchronous, so no nested event loop is needed.
+void GoogleTokenProvider::refresh() {
+    QByteArray assertion = signedAssertion();
+    if (assertion.isEmpty()) {
+        fail("Failed to sign JWT assertion.", false);
+        return;
+    }
+
+    QNetworkRequest req(tokenUrl_);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+    QByteArray body = "grant_type=urn:ietf:params:oauth:grant-type:jwt-bearer&assertion=" + assertion;
+
+    const qint64 startUs = Tracer::instance().nowUs();
+    QNetworkReply *reply = netman_->post(req, body);
+    QObject::connect(reply, &QNetworkReply::finished, context_, [this, reply, startUs]() {
+        reply->deleteLater();
+        Tracer::instance().record("http_request", "network", startUs,
+                                  Tracer::instance().nowUs() - startUs, "oauth");
+
+        QString error;
+        QString accessToken;
+        int expiresIn = 3600;
+        // A 4xx other than 408/429 means the server rejected the assertion (unknown
+        // account, revoked key, clock skew); a network error or 5xx may pass.
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        const bool permanent = status >= 400 && status < 500 && !isRetryableStatus(status);
+        if (reply->error() != QNetworkReply::NoError) {
+            error = reply->errorString();
+        } else {
+            QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+            if (!doc.isObject()) {
+                error = "Invalid token response from OAuth server.";
+            } else {
+                accessToken = doc.object().value("access_token").toString();
+                expiresIn = doc.object().value("expires_in").toInt(3600);
+                if (accessToken.isEmpty()) error = "OAuth token response missing access_token.";
+            }
+        }
+
+        if (!error.isEmpty()) {
+            fail(error, permanent);
+            return;
+        }
+
+        failureCount_ = 0;
+        {
+            QMutexLocker lock(&mutex_);
+            token_ = accessToken;
+            expiry_ = std::time(nullptr) + expiresIn;
+            lastError_.clear();
+            permanentError_ = false;
+        }
+        tokenReady_.wakeAll();
+        // Refresh five minutes before expiry (or halfway through a very short lifetime).
+        const int lead = qMin(300, expiresIn / 2);
+        scheduleRefresh((expiresIn - lead) * 1000);
+    });
+}
+
+} // namespace ocr
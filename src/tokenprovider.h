@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QUrl>
+#include <QWaitCondition>
+#include <atomic>
+
+typedef struct evp_pkey_st EVP_PKEY;
+class QNetworkAccessManager;
+class QTimer;
+
+namespace ocr {
+
+// Mints Google OAuth access tokens for a service account and keeps one fresh on its
+// own thread. The key file is read and the PEM parsed once, at construction; tokens
+// are re-minted a few minutes before they expire, so jobs longer than a token's
+// lifetime never see a stale one. All public methods are thread-safe.
+class GoogleTokenProvider {
+public:
+    // Throws std::runtime_error if the key file is missing or malformed.
+    GoogleTokenProvider(const QString &serviceAccountPath, const QUrl &tokenUrl);
+    ~GoogleTokenProvider();
+
+    GoogleTokenProvider(const GoogleTokenProvider &) = delete;
+    GoogleTokenProvider &operator=(const GoogleTokenProvider &) = delete;
+
+    QString serviceAccountPath() const { return serviceAccountPath_; }
+    QUrl tokenUrl() const { return tokenUrl_; }
+
+    // Starts background refreshing; the first token is requested immediately.
+    void start();
+
+    // Current token, or an empty string if none is valid yet. Never blocks on the network.
+    QString token() const;
+
+    // Returns a valid token, waiting up to timeoutMs for one. Failed attempts are retried
+    // in the background, so this keeps waiting through them; it throws std::runtime_error
+    // on timeout (with the last error), on stop, or once the OAuth server has rejected
+    // the service account outright.
+    QString waitForToken(int timeoutMs, const std::atomic<bool> *stopFlag = nullptr) const;
+
+private:
+    void refresh();
+    void scheduleRefresh(int delayMs);
+    // Records error for waiters and tries again with capped exponential backoff.
+    void fail(const QString &error, bool permanent);
+    QByteArray signedAssertion() const;
+
+    QString serviceAccountPath_;
+    QUrl tokenUrl_;
+    QString clientEmail_;
+    EVP_PKEY *privateKey_;
+
+    QThread thread_;
+    QObject *context_;          // lives on thread_; parent of the objects below
+    QNetworkAccessManager *netman_;
+    QTimer *refreshTimer_;
+    int failureCount_;
+
+    mutable QMutex mutex_;
+    mutable QWaitCondition tokenReady_;
+    QString token_;
+    qint64 expiry_;             // unix epoch seconds
+    QString lastError_;
+    bool permanentError_ = false; // retrying will not help (e.g. the key was revoked)
+};
+
+} // namespace ocr
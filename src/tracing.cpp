@@ -0,0 +1,104 @@
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace ocr {
+
+Tracer &Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer() : enabled_(false) {
+    clock_.start();
+}
+
+void Tracer::start() {
+    QMutexLocker lock(&mutex_);
+    events_.clear();
+    enabled_.store(true);
+}
+
+int Tracer::currentTid() {
+    // Chrome trace viewers group rows by tid, so hand out small stable ids per thread
+    // and remember the QThread name for the metadata events. Caller holds mutex_.
+    thread_local int tid = 0;
+    if (tid == 0) {
+        QString name = QThread::currentThread()->objectName();
+        if (name.isEmpty()) {
+            name = (QThread::currentThread() == QCoreApplication::instance()->thread())
+                       ? QStringLiteral("GUI")
+                       : QString("Thread %1").arg(threadNames_.size() + 1);
+        }
+        threadNames_.append(name);
+        tid = threadNames_.size();
+    }
+    return tid;
+}
+
+void Tracer::record(const char *name, const char *category, qint64 startUs, qint64 durUs,
+                    const QString &detail) {
+    if (!isEnabled()) return;
+    QMutexLocker lock(&mutex_);
+    events_.append({name, category, currentTid(), startUs, durUs, detail});
+}
+
+bool Tracer::writeTo(const QString &path) {
+    QMutexLocker lock(&mutex_);
+    enabled_.store(false);
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    for (int i = 0; i < threadNames_.size(); ++i) {
+        QJsonObject meta;
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = pid;
+        meta["tid"] = i + 1;
+        meta["args"] = QJsonObject{{"name", threadNames_[i]}};
+        traceEvents.append(meta);
+    }
+    for (const Event &ev : events_) {
+        QJsonObject obj;
+        obj["name"] = QString::fromLatin1(ev.name);
+        obj["cat"] = QString::fromLatin1(ev.category);
+        obj["ph"] = "X";
+        obj["pid"] = pid;
+        obj["tid"] = ev.tid;
+        obj["ts"] = ev.startUs;
+        obj["dur"] = ev.durUs;
+        if (!ev.detail.isEmpty()) {
+            obj["args"] = QJsonObject{{"detail", ev.detail}};
+        }
+        traceEvents.append(obj);
+    }
+    events_.clear();
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+TraceSpan::TraceSpan(const char *name, const char *category, const QString &detail)
+    : name_(name), category_(category), detail_(detail), startUs_(-1) {
+    Tracer &t = Tracer::instance();
+    if (t.isEnabled()) startUs_ = t.nowUs();
+}
+
+TraceSpan::~TraceSpan() {
+    if (startUs_ < 0) return;
+    Tracer &t = Tracer::instance();
+    t.record(name_, category_, startUs_, t.nowUs() - startUs_, detail_);
+}
+
+} // namespace ocr
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include <atomic>
+
+namespace ocr {
+
+// Collects complete ("ph":"X") trace events from any thread and writes them as a
+// Chrome trace-event JSON file, viewable in chrome://tracing or ui.perfetto.dev.
+// Recording is off until start() is called, so spans cost one atomic load when idle.
+class Tracer {
+public:
+    static Tracer &instance();
+
+    void start();
+    // Writes all events collected since start() to path and stops recording.
+    bool writeTo(const QString &path);
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    qint64 nowUs() const { return clock_.nsecsElapsed() / 1000; }
+    void record(const char *name, const char *category, qint64 startUs, qint64 durUs,
+                const QString &detail);
+
+private:
+    Tracer();
+
+    struct Event {
+        const char *name;
+        const char *category;
+        int tid;
+        qint64 startUs;
+        qint64 durUs;
+        QString detail;
+    };
+
+    int currentTid();
+
+    std::atomic<bool> enabled_;
+    QElapsedTimer clock_;
+    QMutex mutex_;
+    QVector<Event> events_;
+    QVector<QString> threadNames_; // index = tid - 1
+};
+
+// RAII span: records the time between construction and destruction on the calling thread.
+// name and category must be string literals (they are stored by pointer).
+class TraceSpan {
+public:
+    explicit TraceSpan(const char *name, const char *category = "pipeline",
+                       const QString &detail = QString());
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name_;
+    const char *category_;
+    QString detail_;
+    qint64 startUs_;
+};
+
+} // namespace ocr
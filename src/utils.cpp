@@ -44,4 +44,20 @@ QString findTessdataDir(const QString &tessExecutablePath) {
     return QString();
 }
 
+QString findModelSetDir(const QString &tessdataDir, const QString &modelSet) {
+    if (modelSet.isEmpty()) return tessdataDir;
+
+    const QByteArray envName = "OCR_TESSDATA_" + modelSet.toUpper().toLatin1();
+    const QString fromEnv = qEnvironmentVariable(envName.constData());
+    if (!fromEnv.isEmpty() && QDir(fromEnv).exists()) return fromEnv;
+
+    if (tessdataDir.isEmpty()) return tessdataDir;
+    const QString name = "tessdata_" + modelSet;
+    QDir parent(tessdataDir);
+    parent.cdUp();
+    if (parent.exists(name)) return parent.absoluteFilePath(name);
+    if (QDir(tessdataDir).exists(name)) return QDir(tessdataDir).absoluteFilePath(name);
+    return tessdataDir;
+}
+
 } // namespace ocr
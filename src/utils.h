@@ -8,4 +8,9 @@ namespace ocr {
 // string if not found.
 QString findTessdataDir(const QString &tessExecutablePath);
 
+// Directory holding the "fast" or "best" model set for tessdataDir: $OCR_TESSDATA_FAST /
+// $OCR_TESSDATA_BEST if set, else a tessdata_fast / tessdata_best directory next to or
+// inside tessdataDir. Falls back to tessdataDir when the set is not installed.
+QString findModelSetDir(const QString &tessdataDir, const QString &modelSet);
+
 } // namespace ocr
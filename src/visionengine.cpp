@@ -0,0 +1,95 @@
+#include "visionengine.h"
+#include "connectionpool.h"
+#include "ratelimiter.h"
+#include "tokenprovider.h"
+#include "visionrequest.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QUrl>
+#include <stdexcept>
+
+namespace ocr {
+
+static int visionThreads(const VisionSettings &settings) {
+    return settings.limiter ? settings.limiter->limits().maxConcurrency : RateLimits().maxConcurrency;
+}
+
+VisionEngine::VisionEngine(const VisionSettings &settings, const std::atomic<bool> *stopFlag)
+    : QueuedOcrEngine(visionThreads(settings), "Vision"), settings_(settings), stopFlag_(stopFlag) {
+    if (!settings_.retryBudget) settings_.retryBudget = std::make_shared<RetryBudget>(settings_.retryPolicy);
+}
+
+VisionEngine::~VisionEngine() {
+    shutdown();
+}
+
+EngineCapabilities VisionEngine::capabilities() const {
+    EngineCapabilities caps;
+    caps.name = "Google Vision";
+    // images:annotate takes up to 16 images, but one per request keeps retries,
+    // hedges and failures per page.
+    caps.maxBatchSize = 1;
+    caps.preferredConcurrency = threadCount();
+    caps.cpuBound = false;
+    caps.pixelFormats = {PixelFormat::Png};
+    caps.workingBytes = kResponseBytes;
+    return caps;
+}
+
+void VisionEngine::startWorker(int /*worker*/) {
+    preconnect({settings_.endpoints.visionAnnotateUrl()});
+}
+
+OcrOutcome VisionEngine::read(const OcrPage &page, int /*worker*/) {
+    if (page.png.isEmpty()) throw std::runtime_error("Google Vision needs a PNG page.");
+    const std::atomic<bool> *stopFlag = page.stopFlag ? page.stopFlag : stopFlag_;
+    // Pages of a stopped job may still be queued behind the next job's.
+    if (stopFlag && stopFlag->load()) throw std::runtime_error("Process stopped by user.");
+    QJsonObject feature;
+    feature["type"] = "DOCUMENT_TEXT_DETECTION";
+    QJsonArray features;
+    features.append(feature);
+    QJsonObject fields;
+    fields["features"] = features;
+    if (!page.languageHint.isEmpty()) {
+        QJsonObject imageContext;
+        imageContext["languageHints"] = QJsonArray{page.languageHint};
+        fields["imageContext"] = imageContext;
+    }
+
+    QNetworkRequest req;
+    QUrl url = settings_.endpoints.visionAnnotateUrl();
+    if (settings_.tokenProvider) {
+        // The provider refreshes in the background; this only waits on the very first mint.
+        QString token = settings_.tokenProvider->waitForToken(30000, stopFlag);
+        req.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
+    } else if (!settings_.apiKey.isEmpty()) {
+        url.setQuery(QString("key=%1").arg(settings_.apiKey));
+    } else {
+        throw std::runtime_error("Google Vision requires an API key or a service account JSON file.");
+    }
+    req.setUrl(url);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    HttpClient http(threadNetworkManager(), settings_.retryPolicy,
+                    page.retryBudget ? page.retryBudget : settings_.retryBudget, stopFlag);
+    http.setRateLimiter(settings_.limiter);
+    // The body is base64-encoded as it is sent rather than built up front.
+    const QByteArray resp = http.post(
+        req, [&]() { return new VisionRequestBody(page.png, fields); }, "vision");
+    // A page Vision rejects throws here and becomes a failed page with a placeholder.
+    const QJsonObject annotation = visionAnnotation(resp);
+
+    OcrOutcome outcome;
+    outcome.text = annotation["text"].toString();
+    if (!page.formats.isEmpty()) {
+        outcome.layout = layoutFromVision(annotation);
+        for (OutputFormat format : page.formats) {
+            if (format == OutputFormat::Pdf) continue;
+            outcome.renderings.insert(format, renderPageFragment(format, outcome.layout, page.pageNumber, page.dpi));
+        }
+    }
+    return outcome;
+}
+
+} // namespace ocr
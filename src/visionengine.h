@@ -0,0 +1,50 @@
+#pragma once
+
+#include "endpoints.h"
+#include "httpclient.h"
+#include "ocrengine.h"
+#include <atomic>
+#include <memory>
+
+namespace ocr {
+
+class AdaptiveLimiter;
+class GoogleTokenProvider;
+
+struct VisionSettings {
+    Endpoints endpoints;
+    QString apiKey;
+    std::shared_ptr<GoogleTokenProvider> tokenProvider; // used instead of apiKey when set
+    RetryPolicy retryPolicy;
+    std::shared_ptr<RetryBudget> retryBudget;
+    std::shared_ptr<AdaptiveLimiter> limiter;
+};
+
+// Google Vision DOCUMENT_TEXT_DETECTION behind the OcrEngine interface. Requests are
+// sent from the engine's own threads, one per slot of the limiter's largest window,
+// each with its long-lived connections (see threadNetworkManager()), so pages waiting
+// on the network never hold a render or Tesseract thread. Takes PNG pages. Meant to be
+// kept across jobs so those connections are too; each page then carries its job's stop
+// flag and retry budget.
+class VisionEngine : public QueuedOcrEngine {
+public:
+    explicit VisionEngine(const VisionSettings &settings, const std::atomic<bool> *stopFlag = nullptr);
+    ~VisionEngine() override;
+
+    EngineCapabilities capabilities() const override;
+
+    // Vision answers with every symbol's bounding box; this much is allowed for the
+    // reply (and its parsed JSON) on top of the upload, which is encoded as it is sent.
+    static constexpr qint64 kResponseBytes = 16 << 20;
+
+protected:
+    OcrOutcome read(const OcrPage &page, int worker) override;
+    // Opens the thread's connection to the annotate endpoint.
+    void startWorker(int worker) override;
+
+private:
+    VisionSettings settings_;
+    const std::atomic<bool> *stopFlag_;
+};
+
+} // namespace ocr
@@ -0,0 +1,97 @@
+#include "visionrequest.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ocr {
+
+static const char kBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+VisionRequestBody::VisionRequestBody(const QByteArray &image, const QJsonObject &fields, QObject *parent)
+    : QIODevice(parent), image_(image), prefix_(R"({"requests":[{"image":{"content":")") {
+    // Splice the serialized remaining fields in after the image object.
+    const QByteArray rest = QJsonDocument(fields).toJson(QJsonDocument::Compact);
+    suffix_ = "\"}";
+    if (rest.size() > 2) suffix_ += "," + rest.mid(1, rest.size() - 2);
+    suffix_ += "}]}";
+    open(QIODevice::ReadOnly);
+}
+
+qint64 VisionRequestBody::size() const {
+    return prefix_.size() + encodedSize() + suffix_.size();
+}
+
+// Writes count base64 characters starting at character offset of the encoded image.
+void VisionRequestBody::encodeAt(qint64 offset, char *out, qint64 count) const {
+    const auto *in = reinterpret_cast<const unsigned char *>(image_.constData());
+    const qint64 n = image_.size();
+    qint64 group = offset / 4;
+    int skip = static_cast<int>(offset % 4);
+    while (count > 0) {
+        const qint64 i = group * 3;
+        const unsigned b0 = in[i];
+        const unsigned b1 = i + 1 < n ? in[i + 1] : 0;
+        const unsigned b2 = i + 2 < n ? in[i + 2] : 0;
+        const char quad[4] = {
+            kBase64Alphabet[b0 >> 2],
+            kBase64Alphabet[((b0 & 0x03) << 4) | (b1 >> 4)],
+            i + 1 < n ? kBase64Alphabet[((b1 & 0x0f) << 2) | (b2 >> 6)] : '=',
+            i + 2 < n ? kBase64Alphabet[b2 & 0x3f] : '=',
+        };
+        const int take = static_cast<int>(std::min<qint64>(4 - skip, count));
+        std::memcpy(out, quad + skip, take);
+        out += take;
+        count -= take;
+        skip = 0;
+        ++group;
+    }
+}
+
+qint64 VisionRequestBody::readData(char *data, qint64 maxSize) {
+    qint64 offset = pos();
+    qint64 written = 0;
+    auto copyFrom = [&](const QByteArray &part, qint64 partStart) {
+        const qint64 from = offset - partStart;
+        if (from < 0 || from >= part.size() || written >= maxSize) return;
+        const qint64 take = std::min<qint64>(part.size() - from, maxSize - written);
+        std::memcpy(data + written, part.constData() + from, take);
+        written += take;
+        offset += take;
+    };
+
+    copyFrom(prefix_, 0);
+    const qint64 imageStart = prefix_.size();
+    const qint64 imageEnd = imageStart + encodedSize();
+    if (offset >= imageStart && offset < imageEnd && written < maxSize) {
+        const qint64 take = std::min(imageEnd - offset, maxSize - written);
+        encodeAt(offset - imageStart, data + written, take);
+        written += take;
+        offset += take;
+    }
+    copyFrom(suffix_, imageEnd);
+    return written;
+}
+
+qint64 VisionRequestBody::writeData(const char *, qint64) {
+    return -1;
+}
+
+QJsonObject visionAnnotation(const QByteArray &reply) {
+    const QJsonDocument doc = QJsonDocument::fromJson(reply);
+    if (!doc.isObject()) throw std::runtime_error("Invalid response from Google Vision.");
+    const QJsonArray responses = doc.object()["responses"].toArray();
+    if (responses.isEmpty()) throw std::runtime_error("Google Vision returned no response for the page.");
+    const QJsonObject response = responses[0].toObject();
+    if (response.contains("error")) {
+        const QJsonObject error = response["error"].toObject();
+        QString message = error["message"].toString();
+        if (message.isEmpty()) message = QString("error code %1").arg(error["code"].toInt());
+        throw std::runtime_error(QString("Google Vision: %1").arg(message).toStdString());
+    }
+    return response["fullTextAnnotation"].toObject();
+}
+
+} // namespace ocr
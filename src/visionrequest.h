@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QJsonObject>
+
+namespace ocr {
+
+// Read-only body for an images:annotate call with a single request:
+//   {"requests":[{"image":{"content":"<base64>"}, <fields>}]}
+// The base64 text is produced on the fly from the encoded image as the network stack
+// reads, so a request in flight holds little more than the image itself instead of
+// its base64, UTF-16 and JSON copies. Random access, so retries can rewind it.
+class VisionRequestBody : public QIODevice {
+public:
+    // fields holds the rest of the request object ("features", "imageContext", ...).
+    VisionRequestBody(const QByteArray &image, const QJsonObject &fields, QObject *parent = nullptr);
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    qint64 encodedSize() const { return (image_.size() + 2) / 3 * 4; }
+    void encodeAt(qint64 offset, char *out, qint64 count) const;
+
+    QByteArray image_;   // implicitly shared with the caller, never copied
+    QByteArray prefix_;
+    QByteArray suffix_;
+};
+
+// The fullTextAnnotation of the reply to a single-image images:annotate call (empty for
+// a page without text). Vision reports a rejected image (unreadable, over quota, internal
+// error) with HTTP 200 and an "error" in its response; that, a missing response or a
+// reply that is not JSON throws std::runtime_error with the reason.
+QJsonObject visionAnnotation(const QByteArray &reply);
+
+} // namespace ocr
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "httpclient.h"
+
+using namespace ocr;
+
+TEST(HttpClientTest, ParsesRetryAfterSeconds) {
+    EXPECT_EQ(parseRetryAfterMs("3"), 3000);
+    EXPECT_EQ(parseRetryAfterMs(" 0 "), 0);
+    EXPECT_EQ(parseRetryAfterMs(""), -1);
+    EXPECT_EQ(parseRetryAfterMs("soon"), -1);
+}
+
+TEST(HttpClientTest, OnlyTransientStatusesAreRetried) {
+    EXPECT_TRUE(isRetryableStatus(429));
+    EXPECT_TRUE(isRetryableStatus(503));
+    EXPECT_FALSE(isRetryableStatus(400));
+    EXPECT_FALSE(isRetryableStatus(401));
+}
+
+TEST(HttpClientTest, BackoffStaysWithinCap) {
+    RetryPolicy policy;
+    policy.baseDelayMs = 100;
+    policy.maxDelayMs = 1000;
+    for (int retry = 1; retry <= 10; ++retry) {
+        int delay = backoffDelayMs(retry, policy);
+        EXPECT_GE(delay, 0);
+        EXPECT_LE(delay, qMin(1000, 100 << (retry - 1)));
+    }
+}
+
+TEST(HttpClientTest, RetryBudgetIsBounded) {
+    RetryPolicy policy;
+    policy.retryBudgetMin = 2;
+    policy.retryBudgetRatio = 0.5;
+    RetryBudget budget(policy);
+    EXPECT_TRUE(budget.tryConsume());
+    EXPECT_TRUE(budget.tryConsume());
+    EXPECT_FALSE(budget.tryConsume());
+    budget.onRequest();
+    EXPECT_FALSE(budget.tryConsume());
+    budget.onRequest();
+    EXPECT_TRUE(budget.tryConsume());
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "llmbatch.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+
+using namespace ocr;
+
+static QByteArray outputLine(const QString &customId, const QString &content) {
+    QJsonObject message{{"role", "assistant"}, {"content", content}};
+    QJsonObject body{{"choices", QJsonArray{QJsonObject{{"index", 0}, {"message", message}}}}};
+    QJsonObject response{{"status_code", 200}, {"body", body}};
+    QJsonObject line{{"custom_id", customId}, {"response", response}, {"error", QJsonValue::Null}};
+    return QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n';
+}
+
+TEST(LlmBatchTest, WritesOneRequestPerLine) {
+    const QList<QJsonObject> bodies = {QJsonObject{{"model", "gpt-4o"}}, QJsonObject{{"model", "gpt-4o-mini"}}};
+    const QList<QByteArray> lines = batchInputJsonl(bodies, "/v1/chat/completions", 5).split('\n');
+    ASSERT_EQ(lines.size(), 3);
+    EXPECT_TRUE(lines[2].isEmpty());
+    const QJsonObject second = QJsonDocument::fromJson(lines[1]).object();
+    EXPECT_EQ(second["custom_id"].toString(), QString("request-6"));
+    EXPECT_EQ(second["method"].toString(), QString("POST"));
+    EXPECT_EQ(second["url"].toString(), QString("/v1/chat/completions"));
+    EXPECT_EQ(second["body"].toObject()["model"].toString(), QString("gpt-4o-mini"));
+}
+
+TEST(LlmBatchTest, ReadsAnswersBackInRequestOrder) {
+    // Output files come in no particular order.
+    BatchResults results;
+    parseBatchOutput(outputLine("request-2", "third") + outputLine("request-0", "first") + "\n", &results);
+    EXPECT_EQ(results.outputs.value(0), QString("first"));
+    EXPECT_EQ(results.outputs.value(2), QString("third"));
+    EXPECT_EQ(results.missing(3), QList<int>({1}));
+    EXPECT_TRUE(results.missing(1).isEmpty());
+}
+
+TEST(LlmBatchTest, KeepsErrorsOfFailedRequests) {
+    BatchResults results;
+    parseBatchOutput(R"({"custom_id": "request-1", "response": null, "error": {"code": "server_error", "message": "overloaded"}}
+{"custom_id": "request-0", "response": {"status_code": 400, "body": {"error": {"message": "bad model"}}}, "error": null}
+{"custom_id": "other-3", "response": null, "error": {"message": "not ours"}}
+)",
+                     &results);
+    EXPECT_TRUE(results.outputs.isEmpty());
+    EXPECT_EQ(results.errors.value(0), QString("bad model"));
+    EXPECT_EQ(results.errors.value(1), QString("overloaded"));
+    EXPECT_EQ(results.errors.size(), 2);
+
+    // An answer from another file wins over the error.
+    parseBatchOutput(outputLine("request-1", "late"), &results);
+    EXPECT_EQ(results.outputs.value(1), QString("late"));
+    EXPECT_FALSE(results.errors.contains(1));
+    EXPECT_EQ(results.missing(2), QList<int>({0}));
+}
+
+TEST(LlmBatchTest, ParsesBatchStatus) {
+    const BatchStatus running = parseBatchStatus(QJsonDocument::fromJson(R"({
+        "id": "batch_1", "status": "in_progress",
+        "request_counts": {"total": 10, "completed": 4, "failed": 1}})").object());
+    EXPECT_EQ(running.id, QString("batch_1"));
+    EXPECT_EQ(running.total, 10);
+    EXPECT_EQ(running.completed, 4);
+    EXPECT_EQ(running.failed, 1);
+    EXPECT_FALSE(running.done());
+
+    const BatchStatus completed = parseBatchStatus(QJsonDocument::fromJson(R"({
+        "id": "batch_1", "status": "completed", "output_file_id": "file-2", "error_file_id": "file-3"})").object());
+    EXPECT_TRUE(completed.done());
+    EXPECT_TRUE(completed.usable());
+    EXPECT_EQ(completed.outputFileId, QString("file-2"));
+    EXPECT_EQ(completed.errorFileId, QString("file-3"));
+
+    const BatchStatus failed = parseBatchStatus(QJsonDocument::fromJson(R"({
+        "id": "batch_1", "status": "failed",
+        "errors": {"data": [{"code": "invalid_json_line", "message": "line 3 is not JSON"}]}})").object());
+    EXPECT_TRUE(failed.done());
+    EXPECT_FALSE(failed.usable());
+    EXPECT_EQ(failed.error, QString("line 3 is not JSON"));
+
+    EXPECT_TRUE(parseBatchStatus(QJsonObject{{"status", "expired"}}).usable());
+    EXPECT_FALSE(parseBatchStatus(QJsonObject{{"status", "cancelled"}}).usable());
+}
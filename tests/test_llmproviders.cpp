@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "llmproviders.h"
+#include <QNetworkRequest>
+#include <QTemporaryFile>
+
+using namespace ocr;
+
+static QString writeTemp(QTemporaryFile &file, const QByteArray &json) {
+    EXPECT_TRUE(file.open());
+    file.write(json);
+    file.flush();
+    return file.fileName();
+}
+
+TEST(LlmProvidersTest, BuiltinsFollowEndpointOverrides) {
+    Endpoints endpoints;
+    endpoints.openAiBaseUrl = "http://127.0.0.1:8080/v1/";
+    const QList<LlmProvider> providers = builtinLlmProviders(endpoints);
+    ASSERT_EQ(providers.size(), 2);
+    EXPECT_EQ(providers[0].label(), QString("OpenAI: gpt-4o"));
+    EXPECT_EQ(providers[0].chatCompletionsUrl(), QUrl("http://127.0.0.1:8080/v1/chat/completions"));
+    EXPECT_EQ(providers[1].label(), QString("OpenRouter: deepseek/deepseek-chat"));
+    EXPECT_TRUE(providers[0].batchApi);
+    EXPECT_FALSE(providers[1].batchApi);
+    EXPECT_EQ(providers[0].apiUrl("/batches"), QUrl("http://127.0.0.1:8080/v1/batches"));
+}
+
+TEST(LlmProvidersTest, LoadsProvidersFromFile) {
+    QTemporaryFile file;
+    const QString path = writeTemp(file, R"({"providers": [
+        {"name": "Local", "baseUrl": "http://localhost:8080/v1", "auth": "none",
+         "model": "qwen2.5-7b-instruct", "maxContextTokens": 32768, "maxConcurrency": 4},
+        {"name": "Azure", "baseUrl": "https://example.openai.azure.com/openai/v1", "auth": "header",
+         "authHeader": "api-key", "model": "gpt-4o-mini", "batchApi": true}]})");
+    const QList<LlmProvider> providers = loadLlmProviders(path);
+    ASSERT_EQ(providers.size(), 2);
+    EXPECT_EQ(providers[0].name, QString("Local"));
+    EXPECT_FALSE(providers[0].needsApiKey());
+    EXPECT_EQ(providers[0].maxContextTokens, 32768);
+    EXPECT_EQ(providers[0].maxConcurrency, 4);
+    EXPECT_EQ(providers[1].auth, QString("header"));
+    EXPECT_FALSE(providers[0].batchApi);
+    EXPECT_TRUE(providers[1].batchApi);
+}
+
+TEST(LlmProvidersTest, RejectsIncompleteEntries) {
+    QTemporaryFile file;
+    const QString path = writeTemp(file, R"({"providers": [{"name": "Local"}]})");
+    EXPECT_THROW(loadLlmProviders(path), std::runtime_error);
+    EXPECT_THROW(loadLlmProviders(path + ".missing"), std::runtime_error);
+}
+
+TEST(LlmProvidersTest, FindsProviderByNameOrLabel) {
+    LlmProvider local;
+    local.name = "Local";
+    local.baseUrl = "http://localhost:11434/v1";
+    local.model = "llama3";
+    const QList<LlmProvider> providers = builtinLlmProviders(Endpoints()) + QList<LlmProvider>{local};
+
+    LlmProvider found;
+    ASSERT_TRUE(findLlmProvider(providers, "Local", &found));
+    EXPECT_EQ(found.model, QString("llama3"));
+    // Model names may contain colons.
+    ASSERT_TRUE(findLlmProvider(providers, "Local: llama3:8b", &found));
+    EXPECT_EQ(found.model, QString("llama3:8b"));
+    ASSERT_TRUE(findLlmProvider(providers, "OpenRouter: deepseek/deepseek-chat", &found));
+    EXPECT_EQ(found.name, QString("OpenRouter"));
+    EXPECT_FALSE(findLlmProvider(providers, "Nowhere: model", &found));
+}
+
+TEST(LlmProvidersTest, AuthorizesAccordingToScheme) {
+    LlmProvider provider;
+    QNetworkRequest bearer;
+    provider.authorize(bearer, "sk-test");
+    EXPECT_EQ(bearer.rawHeader("Authorization"), QByteArray("Bearer sk-test"));
+    EXPECT_THROW(provider.authorize(bearer, QString()), std::runtime_error);
+
+    provider.auth = "header";
+    provider.authHeader = "api-key";
+    QNetworkRequest header;
+    provider.authorize(header, "k");
+    EXPECT_EQ(header.rawHeader("api-key"), QByteArray("k"));
+
+    provider.auth = "none";
+    QNetworkRequest none;
+    provider.authorize(none, QString());
+    EXPECT_FALSE(none.hasRawHeader("Authorization"));
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "llmstage.h"
+#include "pagefailures.h"
+#include <QJsonArray>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+
+using namespace ocr;
+
+static LlmSettings settings(double qualityGate) {
+    LlmSettings s;
+    s.provider.name = "Local";
+    s.provider.baseUrl = "http://localhost:8080/v1";
+    s.provider.auth = "none";
+    s.provider.model = "gpt-4o";
+    s.prompt = "Fix the OCR errors.";
+    s.chunkTokenBudget = 1000;
+    s.qualityGate = qualityGate;
+    s.expectedScripts = scriptsForLanguage("eng");
+    s.normalize = false;
+    return s;
+}
+
+static const QString kClean = "The quick brown fox jumps over the lazy dog near the river bank.";
+static const QString kGarbled = "T#e q~ick br0wn f|x ju@ps ov3r t}e l&zy d0g n€ar t#e r!ver b~nk.";
+
+TEST(LlmStageTest, PassesCleanAndFailedPagesThroughWithoutCalls) {
+    LlmStage stage(settings(0.5));
+    stage.addPage(1, kClean, 96, 0.98);
+    const QString placeholder = failurePlaceholder(2, "render failed");
+    stage.addPage(2, placeholder, -1, -1, true);
+    EXPECT_EQ(stage.cleanPages(), 1);
+
+    // Nothing left for the LLM, so nothing goes out.
+    EXPECT_EQ(stage.run(), kClean + "\n\n" + placeholder);
+    EXPECT_EQ(stage.batchCount(), 0);
+}
+
+TEST(LlmStageTest, BatchesDoNotSpanPassedThroughPages) {
+    LlmStage stage(settings(0.5));
+    stage.addPage(1, kGarbled, 20, 0.1);
+    EXPECT_EQ(stage.batchCount(), 0); // still filling
+    stage.addPage(2, kClean, 96, 0.98);
+    EXPECT_EQ(stage.batchCount(), 1);
+    EXPECT_EQ(stage.cleanPages(), 1);
+}
+
+TEST(LlmStageTest, WithoutAGateEveryPageGoesToTheLlm) {
+    LlmStage stage(settings(0));
+    stage.addPage(1, kClean, 96, 0.98);
+    stage.addPage(2, failurePlaceholder(2, "timeout"), -1, -1, true);
+    EXPECT_EQ(stage.cleanPages(), 0);
+    EXPECT_EQ(stage.batchCount(), 1);
+}
+
+TEST(LlmStageTest, PayloadCarriesPromptModelAndText) {
+    LlmStage stage(settings(0));
+    const QJsonObject body = stage.payload("page text", "(Batch 1 of 2)");
+    EXPECT_EQ(body["model"].toString(), QString("gpt-4o"));
+    const QJsonArray messages = body["messages"].toArray();
+    ASSERT_EQ(messages.size(), 2);
+    const QString user = messages[1].toObject()["content"].toString();
+    EXPECT_TRUE(user.startsWith("Fix the OCR errors."));
+    EXPECT_TRUE(user.contains("(Batch 1 of 2)"));
+    EXPECT_TRUE(user.contains("---\npage text\n---"));
+}
+
+TEST(LlmThreadsTest, RunsOnTheSameThreadsEveryTime) {
+    LlmThreads threads(2, QUrl("http://localhost:8080/v1/chat/completions"));
+    EXPECT_EQ(threads.threadCount(), 2);
+    QMutex mutex;
+    QSet<QThread *> first;
+    QSet<QThread *> second;
+    threads.run(2, [&](QNetworkAccessManager *) {
+        QMutexLocker lock(&mutex);
+        first.insert(QThread::currentThread());
+    });
+    threads.run(5, [&](QNetworkAccessManager *) { // capped at the thread count
+        QMutexLocker lock(&mutex);
+        second.insert(QThread::currentThread());
+    });
+    EXPECT_EQ(first.size(), 2);
+    EXPECT_FALSE(first.contains(QThread::currentThread()));
+    EXPECT_EQ(first, second);
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "memorybudget.h"
+#include <QThread>
+#include <atomic>
+
+using namespace ocr;
+
+TEST(MemoryBudgetTest, ReservationsAreReturnedWhenReleased) {
+    MemoryBudget budget(100);
+    {
+        MemoryBudget::Reservation a = budget.reserve(60);
+        EXPECT_EQ(budget.inUse(), 60);
+        a.grow(30);
+        EXPECT_EQ(budget.inUse(), 90);
+        MemoryBudget::Reservation moved = std::move(a);
+        EXPECT_EQ(a.bytes(), 0);
+        moved.resize(10);
+        EXPECT_EQ(budget.inUse(), 10);
+    }
+    EXPECT_EQ(budget.inUse(), 0);
+    EXPECT_EQ(budget.peak(), 90);
+}
+
+TEST(MemoryBudgetTest, TryReserveRespectsTheLimit) {
+    MemoryBudget budget(100);
+    MemoryBudget::Reservation a = budget.tryReserve(80);
+    EXPECT_EQ(a.bytes(), 80);
+    MemoryBudget::Reservation b = budget.tryReserve(30);
+    EXPECT_EQ(b.bytes(), 0);
+    EXPECT_EQ(budget.inUse(), 80);
+}
+
+TEST(MemoryBudgetTest, OversizedRequestPassesWhenAlone) {
+    MemoryBudget budget(100);
+    MemoryBudget::Reservation big = budget.reserve(500);
+    EXPECT_EQ(big.bytes(), 500);
+    // Growing an admitted reservation never waits.
+    big.grow(100);
+    EXPECT_EQ(budget.inUse(), 600);
+}
+
+TEST(MemoryBudgetTest, ReserveBlocksUntilMemoryIsReleased) {
+    MemoryBudget budget(100);
+    MemoryBudget::Reservation held = budget.reserve(80);
+    std::atomic<bool> admitted(false);
+    QThread *waiter = QThread::create([&]() {
+        MemoryBudget::Reservation r = budget.reserve(50);
+        admitted = true;
+    });
+    waiter->start();
+    QThread::msleep(100);
+    EXPECT_FALSE(admitted.load());
+    held.release();
+    EXPECT_TRUE(waiter->wait(2000));
+    EXPECT_TRUE(admitted.load());
+    delete waiter;
+}
+
+TEST(MemoryBudgetTest, UrgentAndStoppedWaitersDoNotBlock) {
+    MemoryBudget budget(100);
+    MemoryBudget::Reservation held = budget.reserve(100);
+
+    MemoryBudget::Reservation urgent = budget.reserve(50, nullptr, []() { return true; });
+    EXPECT_EQ(budget.inUse(), 150);
+
+    std::atomic<bool> stop(true);
+    EXPECT_THROW(budget.reserve(50, &stop), std::runtime_error);
+}
+
+TEST(MemoryBudgetTest, ZeroLimitIsUnlimited) {
+    MemoryBudget budget(0);
+    MemoryBudget::Reservation a = budget.reserve(1LL << 40);
+    MemoryBudget::Reservation b = budget.tryReserve(1LL << 40);
+    EXPECT_EQ(b.bytes(), 1LL << 40);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "ocrengine.h"
+#include "ratelimiter.h"
+#include "visionengine.h"
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+using namespace ocr;
+
+namespace {
+
+// Upper-cases the page's language after a short delay; page 13 always fails.
+class FakeEngine : public QueuedOcrEngine {
+public:
+    explicit FakeEngine(int threads) : QueuedOcrEngine(threads, "Fake") {}
+    ~FakeEngine() override { shutdown(); }
+
+    EngineCapabilities capabilities() const override {
+        EngineCapabilities caps;
+        caps.name = "Fake";
+        caps.preferredConcurrency = threadCount();
+        caps.pixelFormats = {PixelFormat::Png};
+        return caps;
+    }
+
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+    QMutex mutex;
+    QSet<int> workers;
+
+protected:
+    OcrOutcome read(const OcrPage &page, int worker) override {
+        {
+            QMutexLocker lock(&mutex);
+            workers.insert(worker);
+        }
+        const int now = ++running;
+        int seen = maxRunning.load();
+        while (now > seen && !maxRunning.compare_exchange_weak(seen, now)) {}
+        QThread::msleep(5);
+        --running;
+        if (page.pageNumber == 13) throw std::runtime_error("unlucky page");
+        OcrOutcome outcome;
+        outcome.text = page.language.toUpper();
+        return outcome;
+    }
+};
+
+} // namespace
+
+TEST(OcrEngineTest, CompletesEveryPageOnBoundedThreads) {
+    auto engine = std::make_unique<FakeEngine>(3);
+    QMutex mutex;
+    QList<OcrOutcome> outcomes;
+    for (int page = 1; page <= 20; ++page) {
+        OcrPage input;
+        input.pageNumber = page;
+        input.language = QString("p%1").arg(page);
+        engine->submit(input, [&](OcrOutcome outcome) {
+            QMutexLocker lock(&mutex);
+            outcomes.append(outcome);
+        });
+    }
+    // Submitted pages are finished, not dropped, when the engine goes away.
+    engine.reset();
+
+    ASSERT_EQ(outcomes.size(), 20);
+    int failed = 0;
+    for (const OcrOutcome &outcome : outcomes) {
+        if (!outcome.ok()) {
+            EXPECT_EQ(outcome.pageNumber, 13);
+            EXPECT_EQ(outcome.error, QString("unlucky page"));
+            ++failed;
+        } else {
+            EXPECT_EQ(outcome.text, QString("P%1").arg(outcome.pageNumber));
+        }
+    }
+    EXPECT_EQ(failed, 1);
+}
+
+TEST(OcrEngineTest, NeverRunsMoreThanItsThreads) {
+    FakeEngine engine(2);
+    std::atomic<int> done(0);
+    for (int page = 1; page <= 10; ++page) {
+        OcrPage input;
+        input.pageNumber = page;
+        engine.submit(input, [&](OcrOutcome) { ++done; });
+    }
+    EXPECT_TRUE(engine.recognize(OcrPage()).ok());
+    while (done.load() < 10) QThread::msleep(1);
+    EXPECT_LE(engine.maxRunning.load(), 2);
+    EXPECT_LE(engine.workers.size(), 2);
+}
+
+TEST(OcrEngineTest, RecognizeWaitsForTheOutcome) {
+    FakeEngine engine(1);
+    OcrPage input;
+    input.pageNumber = 2;
+    input.language = "hin";
+    const OcrOutcome outcome = engine.recognize(input);
+    EXPECT_TRUE(outcome.ok());
+    EXPECT_EQ(outcome.pageNumber, 2);
+    EXPECT_EQ(outcome.text, QString("HIN"));
+}
+
+TEST(OcrEngineTest, VisionIsIoBoundAndSizedByItsLimiter) {
+    RateLimits limits;
+    limits.maxConcurrency = 12;
+    VisionSettings settings;
+    settings.limiter = std::make_shared<AdaptiveLimiter>(limits);
+    VisionEngine vision(settings);
+    const EngineCapabilities caps = vision.capabilities();
+    EXPECT_FALSE(caps.cpuBound);
+    EXPECT_EQ(caps.preferredConcurrency, 12);
+    EXPECT_TRUE(caps.accepts(PixelFormat::Png));
+    EXPECT_FALSE(caps.accepts(PixelFormat::Gray8));
+    EXPECT_GT(caps.workingBytes, 0);
+
+    // No key or token: the page fails instead of the call throwing.
+    OcrPage page;
+    page.png = "not really a png";
+    const OcrOutcome outcome = vision.recognize(page);
+    EXPECT_FALSE(outcome.ok());
+}
+
+TEST(OcrEngineTest, ParsesEngineChoices) {
+    EXPECT_EQ(engineChoice("Tesseract").primary, EngineKind::Tesseract);
+    EXPECT_EQ(engineChoice("Tesseract").fallback, EngineKind::None);
+    EXPECT_EQ(engineChoice("Google Vision").primary, EngineKind::Vision);
+    const EngineChoice cascade = engineChoice("Tesseract + Vision");
+    EXPECT_EQ(cascade.primary, EngineKind::Tesseract);
+    EXPECT_EQ(cascade.fallback, EngineKind::Vision);
+    EXPECT_TRUE(cascade.uses(EngineKind::Vision));
+    EXPECT_EQ(engineChoice("Abbyy").primary, EngineKind::None);
+}
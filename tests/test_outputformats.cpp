@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "outputformats.h"
+#include "searchablepdf.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+
+using namespace ocr;
+
+namespace {
+
+QJsonObject box(int left, int top, int right, int bottom) {
+    QJsonArray vertices;
+    vertices.append(QJsonObject{{"x", left}, {"y", top}});
+    vertices.append(QJsonObject{{"x", right}, {"y", top}});
+    vertices.append(QJsonObject{{"x", right}, {"y", bottom}});
+    vertices.append(QJsonObject{{"x", left}, {"y", bottom}});
+    return QJsonObject{{"vertices", vertices}};
+}
+
+QJsonObject word(const QString &text, const QRect &r, const QString &breakType = QString()) {
+    QJsonArray symbols;
+    for (int i = 0; i < text.size(); ++i) {
+        QJsonObject symbol{{"text", QString(text[i])}};
+        if (i == text.size() - 1 && !breakType.isEmpty()) {
+            symbol["property"] = QJsonObject{{"detectedBreak", QJsonObject{{"type", breakType}}}};
+        }
+        symbols.append(symbol);
+    }
+    return QJsonObject{{"boundingBox", box(r.left(), r.top(), r.left() + r.width(), r.top() + r.height())},
+                       {"confidence", 0.9},
+                       {"symbols", symbols}};
+}
+
+// Two lines of two words in one paragraph.
+QJsonObject visionAnnotation() {
+    QJsonArray words;
+    words.append(word("Hello", QRect(10, 10, 50, 20), "SPACE"));
+    words.append(word("world", QRect(70, 10, 50, 20), "EOL_SURE_SPACE"));
+    words.append(word("a<b", QRect(10, 40, 30, 20), "SPACE"));
+    words.append(word("c&d", QRect(50, 40, 30, 20), "LINE_BREAK"));
+    QJsonObject paragraph{{"boundingBox", box(10, 10, 120, 60)}, {"words", words}};
+    QJsonObject block{{"boundingBox", box(10, 10, 120, 60)}, {"paragraphs", QJsonArray{paragraph}}};
+    QJsonObject page{{"width", 200}, {"height", 100}, {"blocks", QJsonArray{block}}};
+    return QJsonObject{{"text", "Hello world\na<b c&d\n"}, {"pages", QJsonArray{page}}};
+}
+
+} // namespace
+
+TEST(OutputFormats, ParsesNamesAndSkipsUnknownOnes) {
+    EXPECT_EQ(parseOutputFormats({"PDF", " hocr", "docx", "pdf", "alto"}),
+              QList<OutputFormat>({OutputFormat::Pdf, OutputFormat::Hocr, OutputFormat::Alto}));
+    for (const QString &name : outputFormatNames()) {
+        EXPECT_EQ(outputFormatName(parseOutputFormats({name}).value(0)), name);
+    }
+}
+
+TEST(OutputFormats, PathsFollowTheTextOutput) {
+    EXPECT_EQ(outputFormatPath("/out/book.txt", OutputFormat::Hocr), QString("/out/book.hocr"));
+    EXPECT_EQ(outputFormatPath("/out/book.txt", OutputFormat::Tsv), QString("/out/book.tsv"));
+    EXPECT_EQ(outputFormatPath("/out/book.txt", OutputFormat::Alto), QString("/out/book.xml"));
+    EXPECT_EQ(outputFormatPath("/out/book.v2.txt", OutputFormat::Pdf), QString("/out/book.v2.pdf"));
+}
+
+TEST(OutputFormats, VisionWordsAreSplitIntoLinesAtLineBreaks) {
+    const PageLayout layout = layoutFromVision(visionAnnotation());
+    EXPECT_EQ(layout.size, QSize(200, 100));
+    ASSERT_EQ(layout.blocks.size(), 1);
+    ASSERT_EQ(layout.blocks[0].paragraphs.size(), 1);
+    const QList<LayoutLine> lines = layout.blocks[0].paragraphs[0].lines;
+    ASSERT_EQ(lines.size(), 2);
+    ASSERT_EQ(lines[0].words.size(), 2);
+    EXPECT_EQ(lines[0].words[1].text, QString("world"));
+    EXPECT_EQ(lines[0].words[1].confidence, 90);
+    EXPECT_EQ(lines[0].box, QRect(10, 10, 110, 20));
+    EXPECT_EQ(lines[1].words[0].text, QString("a<b"));
+}
+
+TEST(OutputFormats, FragmentsCarryEveryWordWithItsBox) {
+    const PageLayout layout = layoutFromVision(visionAnnotation());
+
+    const QString hocr = QString::fromUtf8(renderPageFragment(OutputFormat::Hocr, layout, 3, 300));
+    EXPECT_TRUE(hocr.contains("id='page_3'"));
+    EXPECT_TRUE(hocr.contains("ppageno 2; scan_res 300 300"));
+    EXPECT_TRUE(hocr.contains("title='bbox 70 10 120 30; x_wconf 90'>world</span>"));
+    EXPECT_TRUE(hocr.contains(">a&lt;b</span>"));
+    EXPECT_EQ(hocr.count("class='ocr_line'"), 2);
+
+    const QStringList rows = QString::fromUtf8(renderPageFragment(OutputFormat::Tsv, layout, 3, 300))
+                                 .split('\n', Qt::SkipEmptyParts);
+    // page, block, paragraph, two lines and four words
+    ASSERT_EQ(rows.size(), 9);
+    EXPECT_EQ(rows[0], QString("1\t3\t0\t0\t0\t0\t0\t0\t200\t100\t-1\t"));
+    EXPECT_EQ(rows.last(), QString("5\t3\t1\t1\t2\t2\t50\t40\t30\t20\t90\tc&d"));
+
+    const QString alto = QString::fromUtf8(renderPageFragment(OutputFormat::Alto, layout, 3, 300));
+    EXPECT_TRUE(alto.contains("PHYSICAL_IMG_NR=\"2\""));
+    EXPECT_TRUE(alto.contains("CONTENT=\"c&amp;d\""));
+    EXPECT_EQ(alto.count("<TextLine"), 2);
+}
+
+TEST(OutputFormats, SearchablePdfIsCompleteAfterFinish) {
+    QByteArray pdf;
+    SearchablePdfWriter writer([&pdf](const QByteArray &bytes) { pdf += bytes; });
+    const PageLayout layout = layoutFromVision(visionAnnotation());
+    const QByteArray jpeg("\xFF\xD8 not a real image \xFF\xD9");
+    writer.addPage(layout, jpeg, layout.size, true, 300);
+    writer.addPage(PageLayout(), jpeg, QSize(200, 100), false, 300);
+    writer.finish();
+
+    EXPECT_EQ(writer.pageCount(), 2);
+    EXPECT_TRUE(pdf.startsWith("%PDF-1.5"));
+    EXPECT_TRUE(pdf.endsWith("%%EOF\n"));
+    EXPECT_TRUE(pdf.contains("/Type /Pages"));
+    EXPECT_TRUE(pdf.contains("/Count 2"));
+    EXPECT_TRUE(pdf.contains("/ColorSpace /DeviceGray"));
+    EXPECT_TRUE(pdf.contains("/ColorSpace /DeviceRGB"));
+    EXPECT_TRUE(pdf.contains(jpeg));
+
+    // The xref offset points at the table.
+    const int startxref = pdf.lastIndexOf("startxref\n");
+    ASSERT_GE(startxref, 0);
+    const qint64 offset = pdf.mid(startxref + 10).split('\n').first().toLongLong();
+    EXPECT_TRUE(pdf.mid(offset).startsWith("xref"));
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "pagebuffers.h"
+#include <QImage>
+#include <leptonica/allheaders.h>
+
+using namespace ocr;
+
+TEST(PageBuffersTest, GrayPixCompositesOnWhite) {
+    QImage image(4, 2, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    image.setPixel(0, 0, qRgb(0, 0, 0));
+    image.setPixel(1, 0, qRgb(255, 255, 255));
+
+    PageBuffer buffer;
+    Pix *pix = buffer.grayPix(image, 300);
+    ASSERT_NE(pix, nullptr);
+    EXPECT_EQ(pixGetDepth(pix), 8);
+    EXPECT_EQ(pixGetXRes(pix), 300);
+    l_uint32 v = 0;
+    pixGetPixel(pix, 0, 0, &v);
+    EXPECT_EQ(v, 0u);
+    pixGetPixel(pix, 1, 0, &v);
+    EXPECT_EQ(v, 255u);
+    pixGetPixel(pix, 3, 1, &v); // transparent = paper
+    EXPECT_EQ(v, 255u);
+}
+
+TEST(PageBuffersTest, SameSizedPagesReuseTheirBuffers) {
+    QImage image(64, 64, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    PageBuffer buffer;
+    Pix *first = buffer.grayPix(image, 300);
+    buffer.png(image);
+    const int warm = buffer.reallocations();
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(buffer.grayPix(image, 300), first);
+        EXPECT_FALSE(buffer.png(image).isEmpty());
+    }
+    EXPECT_EQ(buffer.reallocations(), warm);
+}
+
+TEST(PageBuffersTest, PoolHandsBackReleasedBuffers) {
+    PageBufferPool pool(2);
+    PageBuffer *first = nullptr;
+    {
+        PageBufferPool::Lease lease = pool.acquire();
+        first = &*lease;
+    }
+    PageBufferPool::Lease again = pool.acquire();
+    EXPECT_EQ(&*again, first);
+    EXPECT_EQ(pool.created(), 1);
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include "pagefailures.h"
+
+using namespace ocr;
+
+TEST(PageFailuresTest, PlaceholderKeepsErrorOnOneLine) {
+    EXPECT_EQ(failurePlaceholder(12, "Vision request failed:\nHTTP 500"),
+              "[OCR failed on page 12: Vision request failed: HTTP 500]");
+    EXPECT_EQ(failurePlaceholder(3, ""), "[OCR failed on page 3: unknown error]");
+}
+
+TEST(PageFailuresTest, FindsPlaceholdersInOutput) {
+    const QString output = "page one\n\n" + failurePlaceholder(2, "Failed to render PDF page") +
+                           "\n\npage three\n\n" + failurePlaceholder(4, "bad [json]");
+    const QList<PageFailure> failures = findFailedPages(output);
+    ASSERT_EQ(failures.size(), 2);
+    EXPECT_EQ(failures[0].page, 2);
+    EXPECT_EQ(failures[0].error, "Failed to render PDF page");
+    EXPECT_EQ(failures[1].page, 4);
+    EXPECT_EQ(failures[1].error, "bad [json]");
+}
+
+TEST(PageFailuresTest, PlaceholderTextInsideALineIsNotAFailure) {
+    EXPECT_TRUE(findFailedPages("see [OCR failed on page 2: x] above").isEmpty());
+}
+
+TEST(PageFailuresTest, SplicesOnlyRecoveredPages) {
+    const QString output = "one\n\n" + failurePlaceholder(2, "a") + "\n\nthree\n\n" +
+                           failurePlaceholder(4, "b");
+    const QString spliced = spliceRecoveredPages(output, {{2, "two"}});
+    EXPECT_EQ(spliced, "one\n\ntwo\n\nthree\n\n" + failurePlaceholder(4, "b"));
+    EXPECT_EQ(spliceRecoveredPages(output, {}), output);
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include "pagemodel.h"
+#include <QSignalSpy>
+
+TEST(PageModelTest, TracksPagesThroughTheirStates) {
+    PageModel model;
+    model.reset({3, 4, 5});
+    ASSERT_EQ(model.rowCount(), 3);
+    const QModelIndex first = model.index(0);
+    EXPECT_EQ(model.data(first, PageModel::PageNumberRole).toInt(), 3);
+    EXPECT_EQ(model.data(first, PageModel::StateNameRole).toString(), QString("pending"));
+
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+    model.setState(3, PageModel::Rendering);
+    model.setState(3, PageModel::Recognizing);
+    EXPECT_EQ(changed.count(), 2);
+    EXPECT_EQ(model.data(first, PageModel::StateNameRole).toString(), QString("ocr"));
+
+    model.setResult(3, "first page", 91, 120, 850);
+    EXPECT_EQ(model.data(first, PageModel::StateRole).toInt(), int(PageModel::Done));
+    EXPECT_EQ(model.data(first, PageModel::TextRole).toString(), QString("first page"));
+    EXPECT_EQ(model.data(first, PageModel::ConfidenceRole).toInt(), 91);
+    EXPECT_EQ(model.data(first, PageModel::OcrMsRole).toLongLong(), 850);
+    EXPECT_EQ(model.text(0), QString("first page"));
+    EXPECT_EQ(model.finishedCount(), 1);
+
+    model.setFailed(5, "Failed to render PDF page");
+    EXPECT_EQ(model.data(model.index(2), PageModel::ErrorRole).toString(), QString("Failed to render PDF page"));
+    EXPECT_EQ(model.finishedCount(), 2);
+}
+
+TEST(PageModelTest, IgnoresUnknownPagesAndResets) {
+    PageModel model;
+    model.reset({1});
+    model.setResult(7, "stray", 50, 1, 1);
+    EXPECT_EQ(model.finishedCount(), 0);
+    model.setResult(1, "text", 50, 1, 1);
+    model.reset({1, 2});
+    EXPECT_EQ(model.rowCount(), 2);
+    EXPECT_EQ(model.finishedCount(), 0);
+    EXPECT_TRUE(model.text(0).isEmpty());
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include "ratelimiter.h"
+
+using namespace ocr;
+
+TEST(RateLimiterTest, ParsesResetDurations) {
+    EXPECT_EQ(parseResetDurationMs("1s"), 1000);
+    EXPECT_EQ(parseResetDurationMs("6m0s"), 360000);
+    EXPECT_EQ(parseResetDurationMs("250ms"), 250);
+    EXPECT_EQ(parseResetDurationMs("1.5s"), 1500);
+    EXPECT_EQ(parseResetDurationMs(""), -1);
+    EXPECT_EQ(parseResetDurationMs("later"), -1);
+}
+
+TEST(RateLimiterTest, WindowGrowsOnSuccessAndHalvesOnThrottle) {
+    RateLimits limits;
+    limits.initialConcurrency = 2;
+    limits.maxConcurrency = 8;
+    AdaptiveLimiter limiter(limits);
+    EXPECT_EQ(limiter.window(), 2);
+
+    for (int i = 0; i < 20; ++i) {
+        limiter.acquire(0);
+        limiter.release(AdaptiveLimiter::Outcome::Success, 100);
+    }
+    const int grown = limiter.window();
+    EXPECT_GT(grown, 2);
+    EXPECT_LE(grown, 8);
+
+    limiter.acquire(0);
+    limiter.release(AdaptiveLimiter::Outcome::Throttled, 100, 0);
+    EXPECT_LE(limiter.window(), grown / 2 + 1);
+}
+
+TEST(RateLimiterTest, WindowBoundsInFlightRequests) {
+    RateLimits limits;
+    limits.initialConcurrency = 1;
+    limits.maxConcurrency = 1;
+    AdaptiveLimiter limiter(limits);
+    EXPECT_TRUE(limiter.tryAcquire(0));
+    EXPECT_FALSE(limiter.tryAcquire(0));
+    limiter.release(AdaptiveLimiter::Outcome::Cancelled, 0);
+    EXPECT_TRUE(limiter.tryAcquire(0));
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "textchunker.h"
+
+using namespace ocr;
+
+TEST(TextChunkerTest, EmptyInputProducesNoChunks) {
+    TextChunker chunker(100);
+    EXPECT_TRUE(chunker.addPage("", 1).isEmpty());
+    EXPECT_TRUE(chunker.addPage("  \n\n \n", 2).isEmpty());
+    EXPECT_TRUE(chunker.finish().isEmpty());
+}
+
+TEST(TextChunkerTest, SmallPagesShareOneChunk) {
+    TextChunker chunker(1000);
+    EXPECT_TRUE(chunker.addPage("First page text.", 1).isEmpty());
+    EXPECT_TRUE(chunker.addPage("Second page text.", 2).isEmpty());
+    QVector<TextChunk> chunks = chunker.finish();
+    ASSERT_EQ(chunks.size(), 1);
+    EXPECT_EQ(chunks[0].text, QString("First page text.\n\nSecond page text."));
+    EXPECT_EQ(chunks[0].firstPage, 1);
+    EXPECT_EQ(chunks[0].lastPage, 2);
+}
+
+TEST(TextChunkerTest, BreaksOnlyBetweenParagraphs) {
+    // Each paragraph is 40 ASCII chars = 10 tokens; budget fits two.
+    const QString para = QString(39, 'a') + ".";
+    QVector<TextChunk> chunks = chunkText(para + "\n\n" + para + "\n\n" + para, 20);
+    ASSERT_EQ(chunks.size(), 2);
+    EXPECT_EQ(chunks[0].text, para + "\n\n" + para);
+    EXPECT_EQ(chunks[1].text, para);
+    for (const TextChunk &c : chunks) EXPECT_LE(c.estimatedTokens, 20);
+}
+
+TEST(TextChunkerTest, OversizedParagraphIsSplitAtWhitespace) {
+    QString para;
+    for (int i = 0; i < 200; ++i) para += "word ";
+    QVector<TextChunk> chunks = chunkText(para, 50);
+    ASSERT_GT(chunks.size(), 1);
+    QStringList words;
+    for (const TextChunk &c : chunks) {
+        EXPECT_LE(c.estimatedTokens, 50);
+        words += c.text.split(' ', Qt::SkipEmptyParts);
+    }
+    EXPECT_EQ(words.size(), 200);
+}
+
+TEST(TextChunkerTest, BudgetLeavesRoomForPromptAndOutput) {
+    const ModelLimits limits = modelLimits("gpt-4o");
+    const int budget = TextChunker::budgetForModel("gpt-4o", 500);
+    EXPECT_LE(budget, limits.maxOutputTokens);
+    EXPECT_LE(2 * budget + 500, limits.contextTokens);
+    EXPECT_EQ(TextChunker::budgetForModel("gpt-4o", 500, 1500), 1500);
+}
+
+TEST(TextChunkerTest, IndicTextCostsMoreThanLatin) {
+    const QString latin = "abcdefghij";
+    const QString devanagari = QString::fromUtf8("संस्कृतम्भाषा");
+    EXPECT_GT(estimateTokens(devanagari, "deepseek-chat"), estimateTokens(latin, "deepseek-chat"));
+}
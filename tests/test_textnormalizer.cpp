@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "textnormalizer.h"
+
+using namespace ocr;
+
+static QVector<NormalizedPage> normalizeAll(TextNormalizer &normalizer, const QStringList &pages) {
+    QVector<NormalizedPage> out;
+    for (int i = 0; i < pages.size(); ++i) out += normalizer.addPage(pages[i], i + 1);
+    out += normalizer.finish();
+    return out;
+}
+
+TEST(TextNormalizerTest, RecognisesPageNumbers) {
+    EXPECT_TRUE(isPageNumberLine("12"));
+    EXPECT_TRUE(isPageNumberLine("- 12 -"));
+    EXPECT_TRUE(isPageNumberLine("Page 3 of 40"));
+    EXPECT_TRUE(isPageNumberLine("xiv"));
+    EXPECT_FALSE(isPageNumberLine("civil"));
+    EXPECT_FALSE(isPageNumberLine("Chapter 3"));
+}
+
+TEST(TextNormalizerTest, JoinsWordsBrokenAcrossLines) {
+    EXPECT_EQ(joinHyphenatedLines("an exam-\nple of it"), QString("an example of it"));
+    EXPECT_EQ(joinHyphenatedLines(QString("soft") + QChar(0x00AD) + "\n hyphen"), QString("softhyphen"));
+    // A capital or a number on the next line is not a continuation.
+    EXPECT_EQ(joinHyphenatedLines("North-\nEast"), QString("North-\nEast"));
+    EXPECT_EQ(joinHyphenatedLines("pages 10-\n12"), QString("pages 10-\n12"));
+}
+
+TEST(TextNormalizerTest, StripsRunningHeadersAndPageNumbers) {
+    QStringList pages;
+    for (int p = 1; p <= 5; ++p) {
+        pages << QString("The Annual Report %1\n\nBody text of page %2.\n\n%2").arg(2024).arg(p);
+    }
+    TextNormalizer normalizer;
+    const QVector<NormalizedPage> out = normalizeAll(normalizer, pages);
+    ASSERT_EQ(out.size(), 5);
+    for (int p = 0; p < 5; ++p) {
+        EXPECT_EQ(out[p].pageNumber, p + 1);
+        EXPECT_EQ(out[p].text, QString("Body text of page %1.").arg(p + 1));
+    }
+    EXPECT_GT(normalizer.tokensSaved(), 0);
+}
+
+TEST(TextNormalizerTest, KeepsLinesThatDoNotRepeat) {
+    TextNormalizer normalizer;
+    const QVector<NormalizedPage> out =
+        normalizeAll(normalizer, {"Introduction\nfirst", "Methods\nsecond", "Results\nthird"});
+    ASSERT_EQ(out.size(), 3);
+    EXPECT_EQ(out[0].text, QString("Introduction\nfirst"));
+    EXPECT_EQ(out[2].text, QString("Results\nthird"));
+}
+
+TEST(TextNormalizerTest, NormalizesUnicodeAndWhitespace) {
+    TextNormalizer normalizer;
+    const QVector<NormalizedPage> out =
+        normalizeAll(normalizer, {QString("cafe\u0301   au\tlait  \n\n\n\nnext")});
+    ASSERT_EQ(out.size(), 1);
+    EXPECT_EQ(out[0].text, QString("caf\u00e9 au lait\n\nnext"));
+}
+
+TEST(TextNormalizerTest, HoldsBackPagesUntilTheWindowIsFull) {
+    NormalizationOptions options;
+    options.window = 2;
+    TextNormalizer normalizer(options);
+    EXPECT_TRUE(normalizer.addPage("one", 1).isEmpty());
+    EXPECT_TRUE(normalizer.addPage("two", 2).isEmpty());
+    const QVector<NormalizedPage> out = normalizer.addPage("three", 3);
+    ASSERT_EQ(out.size(), 1);
+    EXPECT_EQ(out[0].pageNumber, 1);
+    EXPECT_EQ(normalizer.finish().size(), 2);
+}
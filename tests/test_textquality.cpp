@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "textquality.h"
+
+using namespace ocr;
+
+TEST(TextQualityTest, MapsLanguagesToScripts) {
+    EXPECT_EQ(scriptsForLanguage("eng"), QList<QChar::Script>{QChar::Script_Latin});
+    const QList<QChar::Script> hinEng = scriptsForLanguage("hin+eng");
+    EXPECT_TRUE(hinEng.contains(QChar::Script_Devanagari));
+    EXPECT_TRUE(hinEng.contains(QChar::Script_Latin));
+    EXPECT_TRUE(scriptsForLanguage("xyz").isEmpty());
+}
+
+TEST(TextQualityTest, CleanTextScoresHigh) {
+    const TextQuality q = assessTextQuality(
+        u"The quick brown fox jumps over the lazy dog.", {QChar::Script_Latin}, 92, 0.95);
+    EXPECT_DOUBLE_EQ(q.scriptConsistency, 1.0);
+    EXPECT_DOUBLE_EQ(q.symbolNoise, 0.0);
+    EXPECT_GT(q.score, 0.9);
+}
+
+TEST(TextQualityTest, WrongScriptAndDebrisScoreLow) {
+    // Devanagari page misread with the Latin model.
+    const TextQuality q = assessTextQuality(u"~|^ Bl} § ~~ ur|| #@ ^", {QChar::Script_Devanagari}, 35, 0.1);
+    EXPECT_LT(q.scriptConsistency, 0.5);
+    EXPECT_GT(q.symbolNoise, 0.3);
+    EXPECT_LT(q.score, 0.4);
+}
+
+TEST(TextQualityTest, DevanagariVowelSignsAreNotNoise) {
+    const TextQuality q = assessTextQuality(u"किताब ।", {QChar::Script_Devanagari});
+    EXPECT_DOUBLE_EQ(q.scriptConsistency, 1.0);
+    EXPECT_DOUBLE_EQ(q.symbolNoise, 0.0);
+}
+
+TEST(TextQualityTest, BlankTextIsClean) {
+    EXPECT_DOUBLE_EQ(assessTextQuality(u"  \n ", {QChar::Script_Latin}, 0).score, 1.0);
+}
+
+TEST(TextQualityTest, PicksMinimalLanguagesForDetectedScript) {
+    EXPECT_EQ(languagesForPage("hin", "Devanagari"), "hin");
+    EXPECT_EQ(languagesForPage("hin", "Latin"), "eng");
+    EXPECT_EQ(languagesForPage("tam", "Tamil"), "tam");
+    // Unsure or unrelated detections keep the old combined model.
+    EXPECT_EQ(languagesForPage("hin", ""), "hin+eng");
+    EXPECT_EQ(languagesForPage("hin", "Han"), "hin+eng");
+    // IAST Sanskrit is Latin but needs the Sanskrit model's diacritics.
+    EXPECT_EQ(languagesForPage("san", "Latin"), "san+eng");
+    EXPECT_EQ(languagesForPage("eng", "Devanagari"), "eng");
+}
+
+TEST(TextQualityTest, ScriptDetectionOnlyWhereItChangesTheLanguages) {
+    EXPECT_FALSE(needsScriptDetection("eng"));
+    EXPECT_FALSE(needsScriptDetection(""));
+    EXPECT_TRUE(needsScriptDetection("hin"));
+    EXPECT_TRUE(needsScriptDetection("san"));
+    EXPECT_TRUE(needsScriptDetection("hin+eng"));
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "threadbudget.h"
+
+using namespace ocr;
+
+TEST(ThreadBudgetTest, PagesTakeCoresBeforeBlocks) {
+    const ThreadBudget many = planThreads(8, 20, 4, 1);
+    EXPECT_EQ(many.pageWorkers, 8);
+    EXPECT_EQ(many.blockThreads, 1);
+
+    const ThreadBudget single = planThreads(8, 1, 4, 1);
+    EXPECT_EQ(single.pageWorkers, 1);
+    EXPECT_EQ(single.blockThreads, 4);
+
+    const ThreadBudget few = planThreads(8, 3, 4, 1);
+    EXPECT_EQ(few.pageWorkers, 3);
+    EXPECT_EQ(few.blockThreads, 2);
+}
+
+TEST(ThreadBudgetTest, OpenMpThreadsShrinkTheOuterShare) {
+    const ThreadBudget b = planThreads(8, 20, 1, 4);
+    EXPECT_EQ(b.openMpThreads, 4);
+    EXPECT_EQ(b.pageWorkers, 2);
+}
+
+TEST(ThreadBudgetTest, WithoutALimitOpenMpGetsTheCoresLeftOver) {
+    const ThreadBudget single = planThreads(8, 1, 1, 0);
+    EXPECT_EQ(single.pageWorkers, 1);
+    EXPECT_EQ(single.openMpThreads, 8);
+
+    const ThreadBudget blocks = planThreads(8, 1, 2, 0);
+    EXPECT_EQ(blocks.blockThreads, 2);
+    EXPECT_EQ(blocks.openMpThreads, 4);
+
+    const ThreadBudget many = planThreads(8, 20, 1, 0);
+    EXPECT_EQ(many.pageWorkers, 8);
+    EXPECT_EQ(many.openMpThreads, 1);
+}
+
+TEST(ThreadBudgetTest, NeverExceedsTheBudget) {
+    for (int total = 1; total <= 16; ++total) {
+        for (int pages = 1; pages <= 10; ++pages) {
+            for (int omp = 0; omp <= 4; ++omp) {
+                const ThreadBudget b = planThreads(total, pages, 3, omp);
+                EXPECT_GE(b.pageWorkers, 1);
+                EXPECT_LE(b.pageWorkers * b.blockThreads * b.openMpThreads, total);
+            }
+        }
+    }
+}
+
+#ifdef __linux__
+#include <QThread>
+#include <pthread.h>
+#include <sched.h>
+
+TEST(ThreadBudgetTest, PinsToAWholeRunOfCores) {
+    if (QThread::idealThreadCount() < 2) GTEST_SKIP() << "needs two CPUs";
+    bool pinned = false;
+    int count = 0;
+    QThread *th = QThread::create([&pinned, &count]() {
+        pinned = pinCurrentThread(0, 2);
+        if (!pinned) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) count = CPU_COUNT(&set);
+    });
+    th->start();
+    th->wait();
+    delete th;
+    if (!pinned) GTEST_SKIP() << "affinity refused";
+    EXPECT_EQ(count, 2);
+}
+#endif
@@ -31,3 +31,17 @@ TEST(UtilsTest, FindsHomebrewStyleShareTessdata) {
     EXPECT_FALSE(found.isEmpty());
     EXPECT_TRUE(found.endsWith("share/tessdata"));
 }
+
+TEST(UtilsTest, FindsModelSetNextToTessdata) {
+    QTemporaryDir td;
+    ASSERT_TRUE(td.isValid());
+    QDir dir(td.path());
+    dir.mkpath("tessdata");
+    dir.mkpath("tessdata_fast");
+    const QString tessdata = dir.absoluteFilePath("tessdata");
+
+    EXPECT_EQ(findModelSetDir(tessdata, ""), tessdata);
+    EXPECT_EQ(findModelSetDir(tessdata, "fast"), dir.absoluteFilePath("tessdata_fast"));
+    // Not installed: keep using the regular models.
+    EXPECT_EQ(findModelSetDir(tessdata, "best"), tessdata);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "visionrequest.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <stdexcept>
+
+using namespace ocr;
+
+static QJsonObject documentTextFields() {
+    QJsonObject feature;
+    feature["type"] = "DOCUMENT_TEXT_DETECTION";
+    QJsonObject fields;
+    fields["features"] = QJsonArray{feature};
+    return fields;
+}
+
+TEST(VisionRequestBodyTest, MatchesJsonDocumentPayload) {
+    for (int n = 0; n < 8; ++n) {
+        const QByteArray image = QByteArray("\x89PNG\r\n\x1a\n", 8).left(n);
+        VisionRequestBody body(image, documentTextFields());
+        const QByteArray streamed = body.readAll();
+        EXPECT_EQ(streamed.size(), body.size());
+
+        const QJsonObject request = QJsonDocument::fromJson(streamed)
+                                        .object()["requests"].toArray()[0].toObject();
+        EXPECT_EQ(request["image"].toObject()["content"].toString().toLatin1(), image.toBase64());
+        EXPECT_EQ(request["features"].toArray()[0].toObject()["type"].toString(),
+                  "DOCUMENT_TEXT_DETECTION");
+    }
+}
+
+TEST(VisionRequestBodyTest, SmallReadsAndSeeksProduceTheSameBytes) {
+    QByteArray image;
+    for (int i = 0; i < 1000; ++i) image.append(static_cast<char>(i * 7));
+    VisionRequestBody body(image, documentTextFields());
+    const QByteArray whole = body.readAll();
+
+    ASSERT_TRUE(body.seek(0));
+    QByteArray pieces;
+    while (!body.atEnd()) pieces += body.read(5);
+    EXPECT_EQ(pieces, whole);
+
+    ASSERT_TRUE(body.seek(41));
+    EXPECT_EQ(body.read(13), whole.mid(41, 13));
+}
+
+TEST(VisionRequestBodyTest, EmptyFieldsStillProduceValidJson) {
+    VisionRequestBody body("abc", QJsonObject());
+    QJsonParseError error;
+    QJsonDocument::fromJson(body.readAll(), &error);
+    EXPECT_EQ(error.error, QJsonParseError::NoError);
+}
+
+TEST(VisionAnnotationTest, ReturnsTheAnnotationOfTheFirstResponse) {
+    const QJsonObject annotation =
+        visionAnnotation(R"({"responses": [{"fullTextAnnotation": {"text": "Hello"}}]})");
+    EXPECT_EQ(annotation["text"].toString(), QString("Hello"));
+    // A page without text has an empty response, not an error.
+    EXPECT_TRUE(visionAnnotation(R"({"responses": [{}]})").isEmpty());
+}
+
+TEST(VisionAnnotationTest, RejectedImagesThrowWithVisionsMessage) {
+    try {
+        visionAnnotation(R"({"responses": [{"error": {"code": 3, "message": "Bad image data."}}]})");
+        FAIL() << "expected an exception";
+    } catch (const std::runtime_error &ex) {
+        EXPECT_NE(std::string(ex.what()).find("Bad image data."), std::string::npos);
+    }
+    EXPECT_THROW(visionAnnotation(R"({"responses": []})"), std::runtime_error);
+    EXPECT_THROW(visionAnnotation("<html>busy</html>"), std::runtime_error);
+}
@@ -0,0 +1,452 @@
+// Local stand-in for the Google Vision, Google OAuth and OpenAI-compatible chat and
+// batch (/files, /batches) APIs.
+// Speaks the same request/response shapes as the real services so the app's network
+// paths can be exercised and benchmarked offline. Point the app at it with e.g.
+//
+//   ocr_mock_server --port 8089 --latency-ms 300 --throttle-rate 0.05 &
+//   OCR_VISION_BASE_URL=http://127.0.0.1:8089 \
+//   OCR_OAUTH_TOKEN_URL=http://127.0.0.1:8089/token \
+//   OCR_OPENAI_BASE_URL=http://127.0.0.1:8089/v1 ./OCRLLMProcessor
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QDebug>
+#include <memory>
+
+namespace {
+
+struct FaultConfig {
+    int latencyMs = 0;
+    int jitterMs = 0;
+    double errorRate = 0.0;    // fraction of requests answered with 503
+    double throttleRate = 0.0; // fraction of requests answered with 429
+    int retryAfterSec = 1;
+    int batchPolls = 2;             // status polls a batch stays in_progress for
+    double batchErrorRate = 0.0;    // fraction of batch requests written to the error file
+};
+
+struct HttpRequest {
+    QByteArray method;
+    QByteArray path;
+    QByteArray body;
+    bool keepAlive = true;
+};
+
+struct HttpResponse {
+    int status = 200;
+    QByteArray body;
+    QList<QPair<QByteArray, QByteArray>> headers;
+};
+
+QByteArray reasonPhrase(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 429: return "Too Many Requests";
+    case 503: return "Service Unavailable";
+    default: return "Error";
+    }
+}
+
+HttpResponse jsonResponse(const QJsonObject &obj, int status = 200) {
+    HttpResponse r;
+    r.status = status;
+    r.body = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    r.headers.append({"Content-Type", "application/json"});
+    return r;
+}
+
+HttpResponse errorResponse(int status, const QString &message) {
+    QJsonObject err;
+    err["code"] = status;
+    err["message"] = message;
+    return jsonResponse(QJsonObject{{"error", err}}, status);
+}
+
+class MockServer : public QObject {
+public:
+    explicit MockServer(const FaultConfig &faults) : faults_(faults) {
+        connect(&server_, &QTcpServer::newConnection, this, &MockServer::onNewConnection);
+    }
+
+    bool listen(quint16 port) {
+        return server_.listen(QHostAddress::LocalHost, port);
+    }
+
+    quint16 port() const { return server_.serverPort(); }
+
+private:
+    void onNewConnection() {
+        while (QTcpSocket *sock = server_.nextPendingConnection()) {
+            connect(sock, &QTcpSocket::readyRead, this, [this, sock]() { onReadyRead(sock); });
+            connect(sock, &QTcpSocket::disconnected, this, [this, sock]() {
+                buffers_.remove(sock);
+                outgoing_.remove(sock);
+                sock->deleteLater();
+            });
+        }
+    }
+
+    // Parses as many complete requests as are buffered on the socket (keep-alive and
+    // pipelining both work) and schedules a response for each after the injected delay.
+    // Responses leave in request order, as HTTP/1.1 requires, however the delays fall.
+    void onReadyRead(QTcpSocket *sock) {
+        QByteArray &buf = buffers_[sock];
+        buf.append(sock->readAll());
+        for (;;) {
+            int headerEnd = buf.indexOf("\r\n\r\n");
+            if (headerEnd < 0) return;
+
+            HttpRequest req;
+            qsizetype contentLength = 0;
+            const QList<QByteArray> lines = buf.left(headerEnd).split('\n');
+            if (lines.isEmpty()) return;
+            const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+            if (requestLine.size() < 2) {
+                sock->disconnectFromHost();
+                return;
+            }
+            req.method = requestLine[0];
+            req.path = requestLine[1];
+            for (int i = 1; i < lines.size(); ++i) {
+                const QByteArray line = lines[i].trimmed();
+                int colon = line.indexOf(':');
+                if (colon < 0) continue;
+                const QByteArray name = line.left(colon).trimmed().toLower();
+                const QByteArray value = line.mid(colon + 1).trimmed();
+                if (name == "content-length") contentLength = value.toLongLong();
+                else if (name == "connection" && value.toLower() == "close") req.keepAlive = false;
+            }
+
+            const qsizetype total = headerEnd + 4 + contentLength;
+            if (buf.size() < total) return;
+            req.body = buf.mid(headerEnd + 4, contentLength);
+            buf.remove(0, total);
+
+            HttpResponse resp = handle(req);
+            int delay = faults_.latencyMs;
+            if (faults_.jitterMs > 0) delay += QRandomGenerator::global()->bounded(faults_.jitterMs + 1);
+            auto slot = std::make_shared<Outgoing>();
+            slot->keepAlive = req.keepAlive;
+            outgoing_[sock].append(slot);
+            QPointer<QTcpSocket> guard(sock);
+            QTimer::singleShot(delay, this, [this, guard, slot, resp]() {
+                QByteArray out = "HTTP/1.1 " + QByteArray::number(resp.status) + " " +
+                                 reasonPhrase(resp.status) + "\r\n";
+                for (const auto &h : resp.headers) out += h.first + ": " + h.second + "\r\n";
+                out += "Content-Length: " + QByteArray::number(resp.body.size()) + "\r\n";
+                out += slot->keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+                out += resp.body;
+                slot->bytes = out;
+                slot->ready = true;
+                if (guard) flush(guard);
+            });
+        }
+    }
+
+    // Writes the responses at the head of sock's queue that are ready; one still
+    // waiting on its delay holds back those behind it.
+    void flush(QTcpSocket *sock) {
+        auto it = outgoing_.find(sock);
+        if (it == outgoing_.end()) return; // disconnected meanwhile
+        QList<std::shared_ptr<Outgoing>> &queue = it.value();
+        while (!queue.isEmpty() && queue.first()->ready) {
+            const std::shared_ptr<Outgoing> next = queue.takeFirst();
+            sock->write(next->bytes);
+            if (!next->keepAlive) {
+                queue.clear();
+                sock->disconnectFromHost();
+                return;
+            }
+        }
+    }
+
+    HttpResponse handle(const HttpRequest &req) {
+        ++requestCount_;
+        const double roll = QRandomGenerator::global()->generateDouble();
+        if (roll < faults_.throttleRate) {
+            HttpResponse r = errorResponse(429, "Rate limit exceeded (mock).");
+            r.headers.append({"Retry-After", QByteArray::number(faults_.retryAfterSec)});
+            return r;
+        }
+        if (roll < faults_.throttleRate + faults_.errorRate) {
+            return errorResponse(503, "Backend unavailable (mock).");
+        }
+
+        const QByteArray path = req.path.split('?').first();
+        if (req.method == "POST" && path.endsWith("/images:annotate")) return handleVision(req);
+        if (req.method == "POST" && path.endsWith("/token")) return handleToken();
+        if (req.method == "POST" && path.endsWith("/chat/completions")) return handleChat(req);
+        if (req.method == "POST" && path.endsWith("/files")) return handleFileUpload(req);
+        if (req.method == "GET" && path.contains("/files/") && path.endsWith("/content")) {
+            return handleFileContent(pathSegment(path, 2));
+        }
+        if (req.method == "POST" && path.endsWith("/batches")) return handleCreateBatch(req);
+        if (req.method == "POST" && path.contains("/batches/") && path.endsWith("/cancel")) {
+            return handleCancelBatch(pathSegment(path, 2));
+        }
+        if (req.method == "GET" && path.contains("/batches/")) return handleBatchStatus(pathSegment(path, 1));
+        return errorResponse(404, "Unknown mock endpoint: " + QString::fromUtf8(path));
+    }
+
+    // The fromEnd-th segment of path, 1 being the last.
+    static QString pathSegment(const QByteArray &path, int fromEnd) {
+        const QList<QByteArray> segments = path.split('/');
+        return segments.size() >= fromEnd ? QString::fromUtf8(segments[segments.size() - fromEnd]) : QString();
+    }
+
+    HttpResponse handleVision(const HttpRequest &req) {
+        QJsonDocument doc = QJsonDocument::fromJson(req.body);
+        if (!doc.isObject()) return errorResponse(400, "Request body is not JSON.");
+        const QJsonArray requests = doc.object()["requests"].toArray();
+        QJsonArray responses;
+        for (int i = 0; i < requests.size(); ++i) {
+            const qsizetype imageBytes =
+                requests[i].toObject()["image"].toObject()["content"].toString().size();
+            QJsonObject annotation;
+            annotation["text"] = QString("Mock OCR text for request %1, image %2 (%3 base64 bytes).\n")
+                                     .arg(requestCount_)
+                                     .arg(i + 1)
+                                     .arg(imageBytes);
+            responses.append(QJsonObject{{"fullTextAnnotation", annotation}});
+        }
+        return jsonResponse(QJsonObject{{"responses", responses}});
+    }
+
+    HttpResponse handleToken() {
+        QJsonObject obj;
+        obj["access_token"] = QString("mock-token-%1").arg(requestCount_);
+        obj["expires_in"] = 3600;
+        obj["token_type"] = "Bearer";
+        return jsonResponse(obj);
+    }
+
+    HttpResponse handleChat(const HttpRequest &req) {
+        QJsonDocument doc = QJsonDocument::fromJson(req.body);
+        if (!doc.isObject()) return errorResponse(400, "Request body is not JSON.");
+        return jsonResponse(chatCompletion(doc.object(), req.body.size()));
+    }
+
+    // Echoes the text between the "---" fences of the last user message, which is
+    // what a well-behaved correction prompt returns for already-clean input.
+    QJsonObject chatCompletion(const QJsonObject &body, qsizetype requestBytes) {
+        const QJsonArray messages = body["messages"].toArray();
+        QString content = messages.isEmpty() ? QString()
+                                             : messages.last().toObject()["content"].toString();
+        int start = content.indexOf("---\n");
+        int end = content.lastIndexOf("\n---");
+        if (start >= 0 && end > start) content = content.mid(start + 4, end - start - 4);
+
+        QJsonObject message;
+        message["role"] = "assistant";
+        message["content"] = content;
+        QJsonObject choice;
+        choice["index"] = 0;
+        choice["message"] = message;
+        choice["finish_reason"] = "stop";
+
+        QJsonObject usage;
+        usage["prompt_tokens"] = int(requestBytes / 4);
+        usage["completion_tokens"] = int(content.size() / 4);
+
+        QJsonObject obj;
+        obj["id"] = QString("chatcmpl-mock-%1").arg(requestCount_);
+        obj["object"] = "chat.completion";
+        obj["model"] = body["model"].toString();
+        obj["choices"] = QJsonArray{choice};
+        obj["usage"] = usage;
+        return obj;
+    }
+
+    // multipart/form-data with a "file" part; the boundary is read off the first line.
+    HttpResponse handleFileUpload(const HttpRequest &req) {
+        const QByteArray delimiter = "\r\n" + req.body.left(req.body.indexOf("\r\n"));
+        const qsizetype part = req.body.indexOf("name=\"file\"");
+        const qsizetype start = part < 0 ? -1 : req.body.indexOf("\r\n\r\n", part);
+        const qsizetype end = start < 0 ? -1 : req.body.indexOf(delimiter, start);
+        if (!req.body.startsWith("--") || end < 0) return errorResponse(400, "Expected a multipart file upload.");
+        const QString id = QString("file-mock-%1").arg(++fileCount_);
+        files_.insert(id, req.body.mid(start + 4, end - start - 4));
+        QJsonObject obj;
+        obj["id"] = id;
+        obj["object"] = "file";
+        obj["bytes"] = int(files_.value(id).size());
+        obj["purpose"] = "batch";
+        return jsonResponse(obj);
+    }
+
+    HttpResponse handleFileContent(const QString &id) {
+        if (!files_.contains(id)) return errorResponse(404, "No such file: " + id);
+        HttpResponse r;
+        r.body = files_.value(id);
+        r.headers.append({"Content-Type", "application/jsonl"});
+        return r;
+    }
+
+    // Answers every line of the input file up front; the batch reports them only after
+    // batchPolls status polls, like a provider working through its queue.
+    HttpResponse handleCreateBatch(const HttpRequest &req) {
+        const QJsonObject body = QJsonDocument::fromJson(req.body).object();
+        const QString inputFileId = body["input_file_id"].toString();
+        if (!files_.contains(inputFileId)) return errorResponse(404, "No such file: " + inputFileId);
+
+        QByteArray output;
+        QByteArray errors;
+        int total = 0;
+        int failed = 0;
+        for (const QByteArray &line : files_.value(inputFileId).split('\n')) {
+            if (line.trimmed().isEmpty()) continue;
+            ++total;
+            const QJsonObject request = QJsonDocument::fromJson(line).object();
+            QJsonObject result;
+            result["id"] = QString("batch_req_mock_%1").arg(total);
+            result["custom_id"] = request["custom_id"];
+            if (QRandomGenerator::global()->generateDouble() < faults_.batchErrorRate) {
+                ++failed;
+                QJsonObject error;
+                error["code"] = "server_error";
+                error["message"] = "Request failed in batch (mock).";
+                result["response"] = QJsonValue::Null;
+                result["error"] = error;
+                errors += QJsonDocument(result).toJson(QJsonDocument::Compact) + '\n';
+                continue;
+            }
+            QJsonObject response;
+            response["status_code"] = 200;
+            response["body"] = chatCompletion(request["body"].toObject(), line.size());
+            result["response"] = response;
+            result["error"] = QJsonValue::Null;
+            output += QJsonDocument(result).toJson(QJsonDocument::Compact) + '\n';
+        }
+
+        MockBatch batch;
+        batch.object["id"] = QString("batch_mock_%1").arg(batches_.size() + 1);
+        batch.object["object"] = "batch";
+        batch.object["endpoint"] = body["endpoint"];
+        batch.object["input_file_id"] = inputFileId;
+        batch.object["completion_window"] = body["completion_window"];
+        batch.object["status"] = "validating";
+        batch.object["request_counts"] = QJsonObject{{"total", total}, {"completed", 0}, {"failed", 0}};
+        batch.output = output;
+        batch.errors = errors;
+        batch.completed = total - failed;
+        batch.failed = failed;
+        batch.pollsLeft = faults_.batchPolls;
+        const QString id = batch.object["id"].toString();
+        batches_.insert(id, batch);
+        return jsonResponse(batch.object);
+    }
+
+    HttpResponse handleBatchStatus(const QString &id) {
+        auto it = batches_.find(id);
+        if (it == batches_.end()) return errorResponse(404, "No such batch: " + id);
+        MockBatch &batch = it.value();
+        const QString status = batch.object["status"].toString();
+        if (status == "validating" || status == "in_progress") {
+            if (batch.pollsLeft-- > 0) {
+                batch.object["status"] = "in_progress";
+            } else {
+                batch.object["status"] = "completed";
+                batch.object["request_counts"] = QJsonObject{{"total", batch.completed + batch.failed},
+                                                             {"completed", batch.completed},
+                                                             {"failed", batch.failed}};
+                if (!batch.output.isEmpty()) {
+                    const QString fileId = QString("file-mock-%1").arg(++fileCount_);
+                    files_.insert(fileId, batch.output);
+                    batch.object["output_file_id"] = fileId;
+                }
+                if (!batch.errors.isEmpty()) {
+                    const QString fileId = QString("file-mock-%1").arg(++fileCount_);
+                    files_.insert(fileId, batch.errors);
+                    batch.object["error_file_id"] = fileId;
+                }
+            }
+        }
+        return jsonResponse(batch.object);
+    }
+
+    HttpResponse handleCancelBatch(const QString &id) {
+        auto it = batches_.find(id);
+        if (it == batches_.end()) return errorResponse(404, "No such batch: " + id);
+        MockBatch &batch = it.value();
+        const QString status = batch.object["status"].toString();
+        if (status != "validating" && status != "in_progress") {
+            return errorResponse(409, "Batch is already " + status + ".");
+        }
+        batch.object["status"] = "cancelled";
+        return jsonResponse(batch.object);
+    }
+
+    struct Outgoing {
+        QByteArray bytes;
+        bool ready = false;
+        bool keepAlive = true;
+    };
+
+    struct MockBatch {
+        QJsonObject object;
+        QByteArray output;
+        QByteArray errors;
+        int completed = 0;
+        int failed = 0;
+        int pollsLeft = 0;
+    };
+
+    FaultConfig faults_;
+    QTcpServer server_;
+    QHash<QTcpSocket *, QByteArray> buffers_;
+    QHash<QTcpSocket *, QList<std::shared_ptr<Outgoing>>> outgoing_;
+    QHash<QString, QByteArray> files_;
+    QHash<QString, MockBatch> batches_;
+    qint64 requestCount_ = 0;
+    int fileCount_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ocr_mock_server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Offline stand-in for the Vision, OAuth and LLM (chat and batch) APIs.");
+    parser.addHelpOption();
+    QCommandLineOption portOpt("port", "Port to listen on (0 = any).", "port", "8089");
+    QCommandLineOption latencyOpt("latency-ms", "Fixed delay before every response.", "ms", "0");
+    QCommandLineOption jitterOpt("jitter-ms", "Extra uniform random delay.", "ms", "0");
+    QCommandLineOption errorOpt("error-rate", "Fraction of requests failing with 503.", "rate", "0");
+    QCommandLineOption throttleOpt("throttle-rate", "Fraction of requests answered with 429.", "rate", "0");
+    QCommandLineOption retryAfterOpt("retry-after", "Retry-After seconds sent with 429.", "sec", "1");
+    QCommandLineOption batchPollsOpt("batch-polls", "Status polls before a batch completes.", "count", "2");
+    QCommandLineOption batchErrorOpt("batch-error-rate", "Fraction of batch requests that fail.", "rate", "0");
+    parser.addOptions({portOpt, latencyOpt, jitterOpt, errorOpt, throttleOpt, retryAfterOpt, batchPollsOpt,
+                       batchErrorOpt});
+    parser.process(app);
+
+    FaultConfig faults;
+    faults.latencyMs = parser.value(latencyOpt).toInt();
+    faults.jitterMs = parser.value(jitterOpt).toInt();
+    faults.errorRate = parser.value(errorOpt).toDouble();
+    faults.throttleRate = parser.value(throttleOpt).toDouble();
+    faults.retryAfterSec = parser.value(retryAfterOpt).toInt();
+    faults.batchPolls = parser.value(batchPollsOpt).toInt();
+    faults.batchErrorRate = parser.value(batchErrorOpt).toDouble();
+
+    MockServer server(faults);
+    if (!server.listen(static_cast<quint16>(parser.value(portOpt).toUInt()))) {
+        qCritical() << "Failed to listen on port" << parser.value(portOpt);
+        return 1;
+    }
+    qInfo().noquote() << QString("Mock API server listening on http://127.0.0.1:%1").arg(server.port());
+    return app.exec();
+}